@@ -0,0 +1,1098 @@
+#include "Algorithms.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <utility>
+
+// resume() bodies are written as plain loops. TRACE_STEP returns a step and records its line;
+// the next call jumps straight back to that line through the switch (as in Duff's device), so
+// every variable that lives across a step must be a member, and no loop may hold an iterator.
+#define TRACE_BEGIN switch (line_) { case 0:
+#define TRACE_STEP(...)                      \
+    do {                                     \
+        step = TraceStep{__VA_ARGS__};       \
+        line_ = __LINE__;                    \
+        return true;                         \
+        case __LINE__:;                      \
+    } while (0)
+#define TRACE_END } line_ = -1; return false;
+
+static const size_t kSnapshotLimit = 16;  // larger data is not printed after each step
+static const int64_t kInfinity = std::numeric_limits<int64_t>::max();
+
+static std::string num(int64_t v) { return std::to_string(v); }
+
+// "5(3(1 -) 8)": a key, then its two subtrees in parentheses, '-' for a missing one
+template <class Node>
+static void printTree(const std::vector<Node> &nodes, int32_t n, std::string &out) {
+    const Node &node = nodes[(size_t)n];
+    out += num(node.key);
+    if (node.left < 0 && node.right < 0) return;
+    out += "(";
+    if (node.left >= 0) printTree(nodes, node.left, out);
+    else out += "-";
+    out += " ";
+    if (node.right >= 0) printTree(nodes, node.right, out);
+    else out += "-";
+    out += ")";
+}
+
+bool AlgorithmTrace::finish(uint64_t maxSteps) {
+    TraceStep step;
+    for (uint64_t i = 0; i < maxSteps; ++i) {
+        if (!next(step)) return true;
+    }
+    return false;
+}
+
+std::string AlgorithmTrace::summary() const {
+    static const char *names[TraceStep::kKinds] = {
+        "compares", "swaps", "writes", "pivots", "found", "not found", "hashes", "inserts", "deletes",
+        "left rotations", "right rotations", "visits", "discoveries", "finished", "relaxations"};
+    std::string out;
+    for (int k = 0; k < TraceStep::kKinds; ++k) {
+        if (!counts_[k]) continue;
+        if (!out.empty()) out += ", ";
+        out += num((int64_t)counts_[k]) + " " + names[k];
+    }
+    return out.empty() ? "no steps" : out;
+}
+
+// ---- Arrays ----
+
+class ArrayTrace : public AlgorithmTrace {
+public:
+    explicit ArrayTrace(std::vector<int64_t> a) : a_(std::move(a)), n_((int64_t)a_.size()) {}
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Compare:
+            return "compare a[" + num(s.a) + "]=" + num(s.x) + " with a[" + num(s.b) + "]=" + num(s.y);
+        case TraceStep::Swap:
+            return "swap a[" + num(s.a) + "] and a[" + num(s.b) + "]";
+        case TraceStep::Write:
+            return "a[" + num(s.a) + "] = " + num(s.x);
+        case TraceStep::Pivot:
+            return "pivot a[" + num(s.a) + "]=" + num(s.x);
+        default:
+            return "";
+        }
+    }
+    std::string snapshot() const override {
+        if (a_.size() > kSnapshotLimit) return "";
+        std::string out = "[";
+        for (size_t i = 0; i < a_.size(); ++i) out += (i ? " " : "") + num(a_[i]);
+        return out + "]";
+    }
+
+protected:
+    std::vector<int64_t> a_;
+    int64_t n_;
+    int64_t i_ = 0, j_ = 0;
+};
+
+class BubbleSort : public ArrayTrace {
+public:
+    using ArrayTrace::ArrayTrace;
+
+protected:
+    bool swapped_ = false;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (i_ = 0; i_ + 1 < n_; ++i_) {
+            swapped_ = false;
+            for (j_ = 0; j_ + 1 < n_ - i_; ++j_) {
+                TRACE_STEP(TraceStep::Compare, j_, j_ + 1, a_[j_], a_[j_ + 1]);
+                if (a_[j_] > a_[j_ + 1]) {
+                    std::swap(a_[j_], a_[j_ + 1]);
+                    swapped_ = true;
+                    TRACE_STEP(TraceStep::Swap, j_, j_ + 1, a_[j_], a_[j_ + 1]);
+                }
+            }
+            if (!swapped_) break;  // a pass without swaps: already sorted
+        }
+        TRACE_END
+    }
+};
+
+class InsertionSort : public ArrayTrace {
+public:
+    using ArrayTrace::ArrayTrace;
+    std::string describe(const TraceStep &s) const override {
+        if (s.kind == TraceStep::Compare) return "compare a[" + num(s.a) + "]=" + num(s.x) + " with " + num(s.y);
+        return ArrayTrace::describe(s);
+    }
+
+protected:
+    int64_t key_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (i_ = 1; i_ < n_; ++i_) {
+            key_ = a_[i_];
+            // Shift the larger elements of the sorted prefix one place right
+            for (j_ = i_ - 1; j_ >= 0; --j_) {
+                TRACE_STEP(TraceStep::Compare, j_, i_, a_[j_], key_);
+                if (a_[j_] <= key_) break;
+                a_[j_ + 1] = a_[j_];
+                TRACE_STEP(TraceStep::Write, j_ + 1, 0, a_[j_ + 1], 0);
+            }
+            if (j_ + 1 != i_) {
+                a_[j_ + 1] = key_;
+                TRACE_STEP(TraceStep::Write, j_ + 1, 0, key_, 0);
+            }
+        }
+        TRACE_END
+    }
+};
+
+class SelectionSort : public ArrayTrace {
+public:
+    using ArrayTrace::ArrayTrace;
+
+protected:
+    int64_t min_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (i_ = 0; i_ + 1 < n_; ++i_) {
+            min_ = i_;
+            for (j_ = i_ + 1; j_ < n_; ++j_) {
+                TRACE_STEP(TraceStep::Compare, j_, min_, a_[j_], a_[min_]);
+                if (a_[j_] < a_[min_]) min_ = j_;
+            }
+            if (min_ != i_) {
+                std::swap(a_[i_], a_[min_]);
+                TRACE_STEP(TraceStep::Swap, i_, min_, a_[i_], a_[min_]);
+            }
+        }
+        TRACE_END
+    }
+};
+
+// Bottom-up: merges runs of 1, 2, 4, ... elements, so no recursion stack has to be kept
+class MergeSort : public ArrayTrace {
+public:
+    using ArrayTrace::ArrayTrace;
+    std::string describe(const TraceStep &s) const override {
+        if (s.kind == TraceStep::Compare) return "compare " + num(s.x) + " (left run) with " + num(s.y) + " (right run)";
+        return ArrayTrace::describe(s);
+    }
+
+protected:
+    std::vector<int64_t> run_;  // copy of the two runs being merged
+    int64_t width_ = 0, lo_ = 0, mid_ = 0, hi_ = 0, k_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (width_ = 1; width_ < n_; width_ *= 2) {
+            for (lo_ = 0; lo_ + width_ < n_; lo_ += 2 * width_) {
+                mid_ = lo_ + width_;
+                hi_ = std::min(lo_ + 2 * width_, n_);
+                run_.assign(a_.begin() + lo_, a_.begin() + hi_);
+                i_ = lo_;
+                j_ = mid_;
+                for (k_ = lo_; i_ < mid_ && j_ < hi_; ++k_) {
+                    TRACE_STEP(TraceStep::Compare, i_, j_, run_[i_ - lo_], run_[j_ - lo_]);
+                    a_[k_] = run_[j_ - lo_] < run_[i_ - lo_] ? run_[j_++ - lo_] : run_[i_++ - lo_];
+                    TRACE_STEP(TraceStep::Write, k_, 0, a_[k_], 0);
+                }
+                // Whatever is left of the right run is already in place
+                for (; i_ < mid_; ++k_) {
+                    a_[k_] = run_[i_++ - lo_];
+                    TRACE_STEP(TraceStep::Write, k_, 0, a_[k_], 0);
+                }
+            }
+        }
+        TRACE_END
+    }
+};
+
+// Lomuto partition around the middle element; ranges wait on an explicit stack, the larger
+// one pushed first, so the stack stays O(log n) deep
+class QuickSort : public ArrayTrace {
+public:
+    using ArrayTrace::ArrayTrace;
+
+protected:
+    std::vector<std::pair<int64_t, int64_t>> ranges_;
+    int64_t lo_ = 0, hi_ = 0, mid_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        if (n_ > 1) ranges_.push_back({0, n_ - 1});
+        while (!ranges_.empty()) {
+            lo_ = ranges_.back().first;
+            hi_ = ranges_.back().second;
+            ranges_.pop_back();
+            mid_ = lo_ + (hi_ - lo_) / 2;
+            if (mid_ != hi_) {
+                std::swap(a_[mid_], a_[hi_]);
+                TRACE_STEP(TraceStep::Swap, mid_, hi_, a_[mid_], a_[hi_]);
+            }
+            TRACE_STEP(TraceStep::Pivot, hi_, 0, a_[hi_], 0);
+            i_ = lo_;
+            for (j_ = lo_; j_ < hi_; ++j_) {
+                TRACE_STEP(TraceStep::Compare, j_, hi_, a_[j_], a_[hi_]);
+                if (a_[j_] < a_[hi_]) {
+                    if (i_ != j_) {
+                        std::swap(a_[i_], a_[j_]);
+                        TRACE_STEP(TraceStep::Swap, i_, j_, a_[i_], a_[j_]);
+                    }
+                    ++i_;
+                }
+            }
+            if (i_ != hi_) {
+                std::swap(a_[i_], a_[hi_]);
+                TRACE_STEP(TraceStep::Swap, i_, hi_, a_[i_], a_[hi_]);
+            }
+            // The pivot is final at i_
+            {
+                std::pair<int64_t, int64_t> left{lo_, i_ - 1}, right{i_ + 1, hi_};
+                if (left.second - left.first < right.second - right.first) std::swap(left, right);
+                if (left.second > left.first) ranges_.push_back(left);
+                if (right.second > right.first) ranges_.push_back(right);
+            }
+        }
+        TRACE_END
+    }
+};
+
+// Build a max-heap bottom-up, then (heap sort) move the maximum to the end n-1 times.
+// Both phases sift down with the same loop.
+class HeapSort : public ArrayTrace {
+public:
+    HeapSort(std::vector<int64_t> a, bool sort) : ArrayTrace(std::move(a)), sort_(sort) {}
+
+protected:
+    bool sort_;  // false: heapify only
+    int64_t round_ = 0, rounds_ = 0, root_ = 0, child_ = 0, limit_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        rounds_ = n_ / 2 + (sort_ && n_ > 1 ? n_ - 1 : 0);
+        for (round_ = 0; round_ < rounds_; ++round_) {
+            if (round_ < n_ / 2) {
+                root_ = n_ / 2 - 1 - round_;
+                limit_ = n_;
+            } else {
+                limit_ = n_ - 1 - (round_ - n_ / 2);
+                std::swap(a_[0], a_[limit_]);
+                TRACE_STEP(TraceStep::Swap, 0, limit_, a_[0], a_[limit_]);
+                root_ = 0;
+            }
+            while ((child_ = 2 * root_ + 1) < limit_) {
+                if (child_ + 1 < limit_) {
+                    TRACE_STEP(TraceStep::Compare, child_, child_ + 1, a_[child_], a_[child_ + 1]);
+                    if (a_[child_ + 1] > a_[child_]) ++child_;
+                }
+                TRACE_STEP(TraceStep::Compare, root_, child_, a_[root_], a_[child_]);
+                if (a_[root_] >= a_[child_]) break;
+                std::swap(a_[root_], a_[child_]);
+                TRACE_STEP(TraceStep::Swap, root_, child_, a_[root_], a_[child_]);
+                root_ = child_;
+            }
+        }
+        TRACE_END
+    }
+};
+
+// ---- Searches ----
+
+// Looks up each target in turn
+class SearchTrace : public ArrayTrace {
+public:
+    SearchTrace(std::vector<int64_t> a, std::vector<int64_t> targets)
+        : ArrayTrace(std::move(a)), targets_(std::move(targets)) {}
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Compare: return "check a[" + num(s.a) + "]=" + num(s.x) + " against " + num(s.y);
+        case TraceStep::Found: return "found " + num(s.x) + " at a[" + num(s.a) + "]";
+        case TraceStep::NotFound: return num(s.x) + " is not in the array";
+        default: return ArrayTrace::describe(s);
+        }
+    }
+
+protected:
+    std::vector<int64_t> targets_;
+    size_t t_ = 0;
+    int64_t target_ = 0;
+};
+
+class LinearSearch : public SearchTrace {
+public:
+    using SearchTrace::SearchTrace;
+
+protected:
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (t_ = 0; t_ < targets_.size(); ++t_) {
+            target_ = targets_[t_];
+            for (i_ = 0; i_ < n_; ++i_) {
+                TRACE_STEP(TraceStep::Compare, i_, 0, a_[i_], target_);
+                if (a_[i_] == target_) {
+                    TRACE_STEP(TraceStep::Found, i_, 0, target_, 0);
+                    break;
+                }
+            }
+            if (i_ == n_) TRACE_STEP(TraceStep::NotFound, -1, 0, target_, 0);
+        }
+        TRACE_END
+    }
+};
+
+class BinarySearch : public SearchTrace {
+public:
+    using SearchTrace::SearchTrace;  // a_ must be sorted
+
+protected:
+    int64_t mid_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (t_ = 0; t_ < targets_.size(); ++t_) {
+            target_ = targets_[t_];
+            for (i_ = 0, j_ = n_ - 1; i_ <= j_;) {
+                mid_ = i_ + (j_ - i_) / 2;
+                TRACE_STEP(TraceStep::Compare, mid_, 0, a_[mid_], target_);
+                if (a_[mid_] == target_) break;
+                if (a_[mid_] < target_) i_ = mid_ + 1;
+                else j_ = mid_ - 1;
+            }
+            if (i_ <= j_) TRACE_STEP(TraceStep::Found, mid_, 0, target_, 0);
+            else TRACE_STEP(TraceStep::NotFound, -1, 0, target_, 0);
+        }
+        TRACE_END
+    }
+};
+
+// Separate chaining over a power-of-two bucket array (at most one key per bucket on average),
+// built before the first step. Chains link element indices, so the table is two int arrays.
+class HashLookup : public SearchTrace {
+public:
+    HashLookup(std::vector<int64_t> a, std::vector<int64_t> targets) : SearchTrace(std::move(a), std::move(targets)) {
+        while (((size_t)1 << bits_) < a_.size()) ++bits_;
+        head_.assign((size_t)1 << bits_, -1);
+        next_.resize(a_.size());
+        for (size_t i = 0; i < a_.size(); ++i) {
+            uint64_t b = bucket(a_[i]);
+            next_[i] = head_[b];
+            head_[b] = (int32_t)i;
+        }
+    }
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Hash: return "hash " + num(s.x) + " to bucket " + num(s.a);
+        case TraceStep::Compare: return "check " + num(s.x) + " in the bucket against " + num(s.y);
+        case TraceStep::Found: return "found " + num(s.x);
+        case TraceStep::NotFound: return num(s.x) + " is not in the table";
+        default: return SearchTrace::describe(s);
+        }
+    }
+    std::string snapshot() const override {
+        if (a_.size() > kSnapshotLimit) return "";
+        std::string out = "buckets:";
+        for (size_t b = 0; b < head_.size(); ++b) {
+            out += " " + num((int64_t)b) + ":";
+            if (head_[b] < 0) out += "-";
+            for (int32_t e = head_[b]; e >= 0; e = next_[(size_t)e])
+                out += num(a_[(size_t)e]) + (next_[(size_t)e] >= 0 ? "," : "");
+        }
+        return out;
+    }
+
+protected:
+    int bits_ = 1;
+    std::vector<int32_t> head_;  // bucket -> first element, -1 if empty
+    std::vector<int32_t> next_;  // element -> next element in its bucket
+    int32_t e_ = -1;
+
+    // Fibonacci hashing: the top bits of key * 2^64/phi
+    uint64_t bucket(int64_t key) const { return ((uint64_t)key * 11400714819323198485ull) >> (64 - bits_); }
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (t_ = 0; t_ < targets_.size(); ++t_) {
+            target_ = targets_[t_];
+            TRACE_STEP(TraceStep::Hash, (int64_t)bucket(target_), 0, target_, 0);
+            for (e_ = head_[bucket(target_)]; e_ >= 0; e_ = next_[(size_t)e_]) {
+                TRACE_STEP(TraceStep::Compare, e_, 0, a_[(size_t)e_], target_);
+                if (a_[(size_t)e_] == target_) break;
+            }
+            if (e_ >= 0) TRACE_STEP(TraceStep::Found, e_, 0, target_, 0);
+            else TRACE_STEP(TraceStep::NotFound, -1, 0, target_, 0);
+        }
+        TRACE_END
+    }
+};
+
+// A plain (unbalanced) binary search tree with the keys inserted in the order given, built
+// before the first step; the lookups are the steps
+class BstLookup : public SearchTrace {
+public:
+    BstLookup(std::vector<int64_t> a, std::vector<int64_t> targets) : SearchTrace(std::move(a), std::move(targets)) {
+        nodes_.reserve(a_.size());
+        for (int64_t key : a_) {
+            int32_t *link = &root_;
+            while (*link >= 0 && nodes_[(size_t)*link].key != key)
+                link = key < nodes_[(size_t)*link].key ? &nodes_[(size_t)*link].left : &nodes_[(size_t)*link].right;
+            if (*link >= 0) continue;  // duplicate
+            *link = (int32_t)nodes_.size();
+            nodes_.push_back(Node{key, -1, -1});
+        }
+    }
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Compare:
+            if (s.x == s.y) return num(s.y) + " vs " + num(s.x) + ": found it";
+            return num(s.y) + " vs " + num(s.x) + ": go " + (s.y < s.x ? "left" : "right");
+        case TraceStep::Found: return "found " + num(s.x);
+        case TraceStep::NotFound: return num(s.x) + " is not in the tree";
+        default: return SearchTrace::describe(s);
+        }
+    }
+    std::string snapshot() const override {
+        if (nodes_.size() > kSnapshotLimit) return "";
+        std::string out;
+        if (root_ >= 0) printTree(nodes_, root_, out);
+        return out;
+    }
+
+protected:
+    struct Node {
+        int64_t key;
+        int32_t left, right;
+    };
+    std::vector<Node> nodes_;
+    int32_t root_ = -1;
+    int32_t cur_ = -1;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (t_ = 0; t_ < targets_.size(); ++t_) {
+            target_ = targets_[t_];
+            for (cur_ = root_; cur_ >= 0;) {
+                TRACE_STEP(TraceStep::Compare, cur_, 0, nodes_[(size_t)cur_].key, target_);
+                if (nodes_[(size_t)cur_].key == target_) break;
+                cur_ = target_ < nodes_[(size_t)cur_].key ? nodes_[(size_t)cur_].left : nodes_[(size_t)cur_].right;
+            }
+            if (cur_ >= 0) TRACE_STEP(TraceStep::Found, cur_, 0, target_, 0);
+            else TRACE_STEP(TraceStep::NotFound, -1, 0, target_, 0);
+        }
+        TRACE_END
+    }
+};
+
+// ---- Search trees ----
+
+// Inserts and deletes keys in a binary search tree, rebalancing it as an AVL tree if asked.
+// Nodes live in one vector and link by index, so a delete or rotation allocates nothing.
+class TreeTrace : public AlgorithmTrace {
+public:
+    struct Op {
+        bool insert;
+        int64_t key;
+    };
+    TreeTrace(std::vector<Op> ops, bool avl) : ops_(std::move(ops)), avl_(avl) {}
+
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Compare:
+            if (s.a == s.b) return num(s.a) + " vs " + num(s.b) + ": found it";
+            return num(s.a) + " vs " + num(s.b) + ": go " + (s.a < s.b ? "left" : "right");
+        case TraceStep::Insert:
+            if (s.y < 0) return "insert " + num(s.a) + " as the root";
+            return "insert " + num(s.a) + " as the " + (s.y ? "right" : "left") + " child of " + num(s.b);
+        case TraceStep::Found:
+            return num(s.a) + " is already in the tree";
+        case TraceStep::NotFound:
+            return num(s.a) + " is not in the tree";
+        case TraceStep::Remove:
+            if (s.x) return "delete " + num(s.a) + ": it has two children, so its successor " + num(s.b) +
+                            " takes its place and the successor's old node is removed";
+            return "delete " + num(s.a) + (s.y ? ": its child moves up" : ": it is a leaf");
+        case TraceStep::RotateLeft:
+        case TraceStep::RotateRight:
+            return std::string("rotate ") + (s.kind == TraceStep::RotateLeft ? "left" : "right") + " at " +
+                   num(s.a) + ": " + num(s.b) + " moves up" +
+                   (s.x ? " (" + num(s.a) + " was " + num(s.x > 0 ? s.x : -s.x) + " levels taller on the " +
+                              (s.x > 0 ? "left)" : "right)")
+                        : " (first half of a double rotation)");
+        default:
+            return "";
+        }
+    }
+
+    std::string snapshot() const override {
+        if (root_ < 0) return "(empty tree)";
+        if (size_ > kSnapshotLimit) return "";
+        std::string out;
+        printTree(nodes_, root_, out);
+        return out;
+    }
+
+protected:
+    struct Node {
+        int64_t key;
+        int32_t left, right;
+        int32_t height;  // of the subtree, a leaf is 1
+    };
+
+    std::vector<Op> ops_;
+    bool avl_;
+    std::vector<Node> nodes_;
+    std::vector<int32_t> free_;  // deleted nodes, reused by inserts
+    int32_t root_ = -1;
+    size_t size_ = 0;
+
+    size_t op_ = 0, up_ = 0;
+    int64_t key_ = 0;
+    int32_t cur_ = -1, next_ = -1, child_ = -1;
+    int balance_ = 0;
+    bool successor_ = false;
+    std::vector<int32_t> path_;  // root .. parent of cur_, for relinking and rebalancing
+
+    int32_t height(int32_t n) const { return n < 0 ? 0 : nodes_[n].height; }
+    int balance(int32_t n) const { return height(nodes_[n].left) - height(nodes_[n].right); }
+    void update(int32_t n) {
+        nodes_[n].height = 1 + std::max(height(nodes_[n].left), height(nodes_[n].right));
+    }
+    // Make the link that pointed to from point to to: parent is the node above, -1 for the root
+    void relink(int32_t parent, int32_t from, int32_t to) {
+        if (parent < 0) root_ = to;
+        else if (nodes_[parent].left == from) nodes_[parent].left = to;
+        else nodes_[parent].right = to;
+    }
+    int32_t rotateLeft(int32_t n) {
+        int32_t r = nodes_[n].right;
+        nodes_[n].right = nodes_[r].left;
+        nodes_[r].left = n;
+        update(n);
+        update(r);
+        return r;
+    }
+    int32_t rotateRight(int32_t n) {
+        int32_t l = nodes_[n].left;
+        nodes_[n].left = nodes_[l].right;
+        nodes_[l].right = n;
+        update(n);
+        update(l);
+        return l;
+    }
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        for (op_ = 0; op_ < ops_.size(); ++op_) {
+            key_ = ops_[op_].key;
+            path_.clear();
+            for (cur_ = root_; cur_ >= 0 && nodes_[cur_].key != key_; cur_ = next_) {
+                TRACE_STEP(TraceStep::Compare, key_, nodes_[cur_].key, 0, 0);
+                path_.push_back(cur_);
+                next_ = key_ < nodes_[cur_].key ? nodes_[cur_].left : nodes_[cur_].right;
+            }
+            if (cur_ >= 0) TRACE_STEP(TraceStep::Compare, key_, key_, 0, 0);
+
+            if (ops_[op_].insert) {
+                if (cur_ >= 0) {
+                    TRACE_STEP(TraceStep::Found, key_, 0, 0, 0);
+                    continue;
+                }
+                if (free_.empty()) {
+                    cur_ = (int32_t)nodes_.size();
+                    nodes_.push_back(Node{key_, -1, -1, 1});
+                } else {
+                    cur_ = free_.back();
+                    free_.pop_back();
+                    nodes_[cur_] = Node{key_, -1, -1, 1};
+                }
+                ++size_;
+                if (path_.empty()) {
+                    root_ = cur_;
+                    TRACE_STEP(TraceStep::Insert, key_, 0, 0, -1);
+                } else {
+                    next_ = path_.back();
+                    if (key_ < nodes_[next_].key) nodes_[next_].left = cur_;
+                    else nodes_[next_].right = cur_;
+                    TRACE_STEP(TraceStep::Insert, key_, nodes_[next_].key, 0, key_ > nodes_[next_].key);
+                }
+            } else {
+                if (cur_ < 0) {
+                    TRACE_STEP(TraceStep::NotFound, key_, 0, 0, 0);
+                    continue;
+                }
+                // Two children: the leftmost node of the right subtree gives up its key and is removed instead
+                successor_ = nodes_[cur_].left >= 0 && nodes_[cur_].right >= 0;
+                if (successor_) {
+                    path_.push_back(cur_);
+                    for (next_ = nodes_[cur_].right; nodes_[next_].left >= 0; next_ = nodes_[next_].left)
+                        path_.push_back(next_);
+                    nodes_[cur_].key = nodes_[next_].key;
+                    cur_ = next_;
+                }
+                // cur_ has one child at most: splice it out
+                child_ = nodes_[cur_].left >= 0 ? nodes_[cur_].left : nodes_[cur_].right;
+                relink(path_.empty() ? -1 : path_.back(), cur_, child_);
+                free_.push_back(cur_);
+                --size_;
+                TRACE_STEP(TraceStep::Remove, key_, nodes_[cur_].key, successor_, child_ >= 0);
+            }
+
+            if (!avl_) continue;
+            // Walk back up: fix heights, and rotate where one side got two levels taller
+            for (up_ = path_.size(); up_-- > 0;) {
+                cur_ = path_[up_];
+                update(cur_);
+                balance_ = balance(cur_);
+                if (balance_ > 1) {
+                    if (balance(nodes_[cur_].left) < 0) {  // left-right case
+                        child_ = nodes_[cur_].left;
+                        nodes_[cur_].left = rotateLeft(child_);
+                        TRACE_STEP(TraceStep::RotateLeft, nodes_[child_].key, nodes_[nodes_[cur_].left].key, 0, 0);
+                    }
+                    next_ = rotateRight(cur_);
+                    relink(up_ ? path_[up_ - 1] : -1, cur_, next_);
+                    TRACE_STEP(TraceStep::RotateRight, nodes_[cur_].key, nodes_[next_].key, balance_, 0);
+                } else if (balance_ < -1) {
+                    if (balance(nodes_[cur_].right) > 0) {  // right-left case
+                        child_ = nodes_[cur_].right;
+                        nodes_[cur_].right = rotateRight(child_);
+                        TRACE_STEP(TraceStep::RotateRight, nodes_[child_].key, nodes_[nodes_[cur_].right].key, 0, 0);
+                    }
+                    next_ = rotateLeft(cur_);
+                    relink(up_ ? path_[up_ - 1] : -1, cur_, next_);
+                    TRACE_STEP(TraceStep::RotateLeft, nodes_[cur_].key, nodes_[next_].key, balance_, 0);
+                }
+            }
+        }
+        TRACE_END
+    }
+};
+
+// ---- Graphs ----
+
+// Undirected, adjacency lists in the order the edges were given. Vertices are numbered densely;
+// labels_ keeps the numbers the user wrote.
+struct Graph {
+    std::vector<int64_t> labels_;
+    std::vector<std::vector<std::pair<int32_t, int64_t>>> adj_;  // (neighbour, weight)
+    int32_t source_ = 0;
+};
+
+class GraphTrace : public AlgorithmTrace {
+public:
+    explicit GraphTrace(Graph g) : g_(std::move(g)), n_((int32_t)g_.adj_.size()) {}
+
+    std::string describe(const TraceStep &s) const override {
+        switch (s.kind) {
+        case TraceStep::Visit:
+            return "visit " + label(s.a) + (s.b >= 0 ? " (from " + label(s.b) + ")" : "") +
+                   (s.x >= 0 ? ", distance " + num(s.x) : "");
+        case TraceStep::Discover:
+            return "discover " + label(s.a) + (s.b >= 0 ? " from " + label(s.b) : "") + ", queue it";
+        case TraceStep::Finish:
+            return "done with " + label(s.a) + ", back" + (s.b >= 0 ? " to " + label(s.b) : "");
+        case TraceStep::Relax:
+            return "edge " + label(s.a) + "-" + label(s.b) + " (" + num(s.y) + "): distance of " + label(s.b) +
+                   " drops to " + num(s.x);
+        case TraceStep::Compare:
+            return "edge " + label(s.a) + "-" + label(s.b) + " (" + num(s.y) + "): " + num(s.x) +
+                   " is no shorter than " + label(s.b) + "'s current distance";
+        default:
+            return "";
+        }
+    }
+
+protected:
+    Graph g_;
+    int32_t n_;
+    std::vector<char> seen_;
+    int32_t u_ = 0, v_ = 0;
+    size_t e_ = 0;
+
+    std::string label(int64_t v) const { return num(g_.labels_[(size_t)v]); }
+    std::string seenList() const {
+        if ((size_t)n_ > kSnapshotLimit || seen_.empty()) return "";
+        std::string out = "seen:";
+        for (int32_t v = 0; v < n_; ++v)
+            if (seen_[(size_t)v]) out += " " + label(v);
+        return out;
+    }
+};
+
+class BreadthFirst : public GraphTrace {
+public:
+    using GraphTrace::GraphTrace;
+    std::string snapshot() const override {
+        if ((size_t)n_ > kSnapshotLimit) return "";
+        std::string out = "queue:";
+        for (size_t i = head_; i < queue_.size(); ++i) out += " " + label(queue_[i]);
+        return head_ == queue_.size() ? out + " (empty)" : out;
+    }
+
+protected:
+    std::vector<int32_t> queue_;  // every vertex discovered; head_ is the front
+    size_t head_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        seen_.assign((size_t)n_, 0);
+        seen_[(size_t)g_.source_] = 1;
+        queue_.push_back(g_.source_);
+        TRACE_STEP(TraceStep::Discover, g_.source_, -1, 0, 0);
+        while (head_ < queue_.size()) {
+            u_ = queue_[head_++];
+            TRACE_STEP(TraceStep::Visit, u_, -1, -1, 0);
+            for (e_ = 0; e_ < g_.adj_[(size_t)u_].size(); ++e_) {
+                v_ = g_.adj_[(size_t)u_][e_].first;
+                if (seen_[(size_t)v_]) continue;
+                seen_[(size_t)v_] = 1;
+                queue_.push_back(v_);
+                TRACE_STEP(TraceStep::Discover, v_, u_, 0, 0);
+            }
+        }
+        TRACE_END
+    }
+};
+
+// Visits in the same order as the recursive version; the stack holds (vertex, next edge)
+class DepthFirst : public GraphTrace {
+public:
+    using GraphTrace::GraphTrace;
+    std::string snapshot() const override { return seenList(); }
+
+protected:
+    std::vector<std::pair<int32_t, size_t>> stack_;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        seen_.assign((size_t)n_, 0);
+        seen_[(size_t)g_.source_] = 1;
+        stack_.push_back({g_.source_, 0});
+        TRACE_STEP(TraceStep::Visit, g_.source_, -1, -1, 0);
+        while (!stack_.empty()) {
+            u_ = stack_.back().first;
+            if (stack_.back().second < g_.adj_[(size_t)u_].size()) {
+                v_ = g_.adj_[(size_t)u_][stack_.back().second++].first;
+                if (seen_[(size_t)v_]) continue;
+                seen_[(size_t)v_] = 1;
+                stack_.push_back({v_, 0});
+                TRACE_STEP(TraceStep::Visit, v_, u_, -1, 0);
+            } else {
+                stack_.pop_back();
+                TRACE_STEP(TraceStep::Finish, u_, stack_.empty() ? -1 : stack_.back().first, 0, 0);
+            }
+        }
+        TRACE_END
+    }
+};
+
+class Dijkstra : public GraphTrace {
+public:
+    using GraphTrace::GraphTrace;
+    std::string snapshot() const override {
+        if ((size_t)n_ > kSnapshotLimit || dist_.empty()) return "";
+        std::string out = "dist:";
+        for (int32_t v = 0; v < n_; ++v)
+            out += " " + label(v) + "=" + (dist_[(size_t)v] == kInfinity ? "inf" : num(dist_[(size_t)v]));
+        return out;
+    }
+
+protected:
+    using Entry = std::pair<int64_t, int32_t>;  // (distance, vertex)
+    std::vector<int64_t> dist_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+    int64_t w_ = 0;
+
+    bool resume(TraceStep &step) override {
+        TRACE_BEGIN
+        dist_.assign((size_t)n_, kInfinity);
+        dist_[(size_t)g_.source_] = 0;
+        heap_.push({0, g_.source_});
+        while (!heap_.empty()) {
+            u_ = heap_.top().second;
+            if (heap_.top().first > dist_[(size_t)u_]) {  // stale: u_ was reached by a shorter path since
+                heap_.pop();
+                continue;
+            }
+            heap_.pop();
+            TRACE_STEP(TraceStep::Visit, u_, -1, dist_[(size_t)u_], 0);
+            for (e_ = 0; e_ < g_.adj_[(size_t)u_].size(); ++e_) {
+                v_ = g_.adj_[(size_t)u_][e_].first;
+                w_ = g_.adj_[(size_t)u_][e_].second;
+                if (dist_[(size_t)u_] + w_ < dist_[(size_t)v_]) {
+                    dist_[(size_t)v_] = dist_[(size_t)u_] + w_;
+                    heap_.push({dist_[(size_t)v_], v_});
+                    TRACE_STEP(TraceStep::Relax, u_, v_, dist_[(size_t)v_], w_);
+                } else {
+                    TRACE_STEP(TraceStep::Compare, u_, v_, dist_[(size_t)u_] + w_, w_);
+                }
+            }
+        }
+        TRACE_END
+    }
+};
+
+// ---- Registry and input ----
+
+const std::vector<Algorithms::Info> &Algorithms::all() {
+    static const std::vector<Info> list = {
+        {"bubble sort", "Bubble sort", "bubble|bubblesort", Input::Array, "O(n^2), O(n) if already sorted"},
+        {"insertion sort", "Insertion sort", "insertion", Input::Array, "O(n^2), O(n) if already sorted"},
+        {"selection sort", "Selection sort", "selection", Input::Array, "O(n^2) always"},
+        {"merge sort", "Merge sort", "merge", Input::Array, "O(n log n), O(n) extra space"},
+        {"quicksort", "Quick sort", "quick|quick sort", Input::Array, "O(n log n) on average, O(n^2) worst case"},
+        {"heap sort", "Heap sort", "heap|heapsort", Input::Array, "O(n log n), in place"},
+        {"heapify", "Heapify (build a max-heap)", "build heap|build max heap", Input::Array, "O(n)"},
+        {"linear search", "Linear search", "linear|sequential search", Input::Search, "O(n)"},
+        {"binary search", "Binary search", "binary", Input::Search, "O(log n) on sorted input"},
+        {"hash table", "Hash table lookup", "hash|hash lookup|hashing|hash map", Input::Search,
+         "O(1) per lookup on average"},
+        {"bst search", "Binary search tree lookup", "bst lookup|tree search|tree lookup", Input::Search,
+         "O(h) per lookup: O(log n) for keys inserted in random order, O(n) for sorted ones"},
+        {"bst", "Binary search tree", "binary search tree|bst insert|bst delete", Input::Keys,
+         "O(h) per operation: O(log n) if balanced, O(n) worst case"},
+        {"avl", "AVL tree", "avl tree|avl insert|avl delete", Input::Keys, "O(log n) per operation"},
+        {"bfs", "Breadth-first search", "breadth first|breadth first search", Input::Graph, "O(V + E)"},
+        {"dfs", "Depth-first search", "depth first|depth first search", Input::Graph, "O(V + E)"},
+        {"dijkstra", "Dijkstra's shortest paths", "shortest path|shortest paths", Input::Graph,
+         "O((V + E) log V) with a binary heap"},
+    };
+    return list;
+}
+
+static std::string squeeze(const std::string &s) {
+    std::string out;
+    for (char c : s)
+        if (c != ' ' && c != '-' && c != '\'') out += c;
+    return out;
+}
+
+const Algorithms::Info *Algorithms::find(const std::string &name) {
+    std::string key = squeeze(name);
+    if (key.empty()) return nullptr;
+    for (auto &algo : all()) {
+        if (squeeze(algo.name) == key) return &algo;
+        std::istringstream aliases(algo.aliases);
+        for (std::string alias; std::getline(aliases, alias, '|');)
+            if (squeeze(alias) == key) return &algo;
+    }
+    return nullptr;
+}
+
+const char *Algorithms::usage(const Info &algo) {
+    switch (algo.input) {
+    case Input::Array: return "5 3 8 1 9 2";
+    case Input::Search: return "1 3 5 8 13 find 8";
+    case Input::Keys: return "5 3 8 1 4 delete 3";
+    case Input::Graph:
+        return std::string(algo.name) == "dijkstra" ? "0-1:4 0-2:1 2-1:2 1-3:5 from 0" : "0-1 0-2 1-3 2-3 from 0";
+    }
+    return "";
+}
+
+static bool parseNumber(const std::string &tok, int64_t &out) {
+    if (tok.empty()) return false;
+    size_t i = tok[0] == '-' ? 1 : 0;
+    if (i == tok.size() || tok.size() - i > 15) return false;
+    for (size_t j = i; j < tok.size(); ++j)
+        if (tok[j] < '0' || tok[j] > '9') return false;
+    out = std::stoll(tok);
+    return true;
+}
+
+static std::unique_ptr<AlgorithmTrace> startArray(const Algorithms::Info &algo, std::vector<int64_t> a) {
+    std::string name = algo.name;
+    if (name == "bubble sort") return std::unique_ptr<AlgorithmTrace>(new BubbleSort(std::move(a)));
+    if (name == "insertion sort") return std::unique_ptr<AlgorithmTrace>(new InsertionSort(std::move(a)));
+    if (name == "selection sort") return std::unique_ptr<AlgorithmTrace>(new SelectionSort(std::move(a)));
+    if (name == "merge sort") return std::unique_ptr<AlgorithmTrace>(new MergeSort(std::move(a)));
+    if (name == "quicksort") return std::unique_ptr<AlgorithmTrace>(new QuickSort(std::move(a)));
+    return std::unique_ptr<AlgorithmTrace>(new HeapSort(std::move(a), name == "heap sort"));
+}
+
+static std::unique_ptr<AlgorithmTrace> startSearch(const Algorithms::Info &algo, std::vector<int64_t> a,
+                                                   std::vector<int64_t> targets) {
+    std::string name = algo.name;
+    if (name == "linear search")
+        return std::unique_ptr<AlgorithmTrace>(new LinearSearch(std::move(a), std::move(targets)));
+    if (name == "hash table") return std::unique_ptr<AlgorithmTrace>(new HashLookup(std::move(a), std::move(targets)));
+    if (name == "bst search") return std::unique_ptr<AlgorithmTrace>(new BstLookup(std::move(a), std::move(targets)));
+    std::sort(a.begin(), a.end());
+    return std::unique_ptr<AlgorithmTrace>(new BinarySearch(std::move(a), std::move(targets)));
+}
+
+static std::unique_ptr<AlgorithmTrace> startGraph(const Algorithms::Info &algo, Graph g) {
+    std::string name = algo.name;
+    if (name == "bfs") return std::unique_ptr<AlgorithmTrace>(new BreadthFirst(std::move(g)));
+    if (name == "dfs") return std::unique_ptr<AlgorithmTrace>(new DepthFirst(std::move(g)));
+    return std::unique_ptr<AlgorithmTrace>(new Dijkstra(std::move(g)));
+}
+
+std::unique_ptr<AlgorithmTrace> Algorithms::random(const Info &algo, size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    // Small inputs get small numbers, so the printed steps stay readable
+    int64_t range = n <= kSnapshotLimit ? 99 : (int64_t)n * 4;
+    std::uniform_int_distribution<int64_t> value(1, range);
+
+    if (algo.input == Input::Graph) {
+        // A random spanning tree keeps every vertex reachable; n more edges add cycles
+        Graph g;
+        g.adj_.resize(n);
+        for (size_t v = 0; v < n; ++v) g.labels_.push_back((int64_t)v);
+        std::uniform_int_distribution<int64_t> weight(1, 9);
+        auto addEdge = [&](size_t u, size_t v) {
+            int64_t w = weight(rng);
+            g.adj_[u].push_back({(int32_t)v, w});
+            g.adj_[v].push_back({(int32_t)u, w});
+        };
+        for (size_t v = 1; v < n; ++v) addEdge(std::uniform_int_distribution<size_t>(0, v - 1)(rng), v);
+        if (n > 1) {
+            std::uniform_int_distribution<size_t> vertex(0, n - 1);
+            for (size_t i = 0; i < n; ++i) {
+                size_t u = vertex(rng), v = vertex(rng);
+                if (u != v) addEdge(u, v);
+            }
+        }
+        return startGraph(algo, std::move(g));
+    }
+
+    std::vector<int64_t> a(n);
+    if (algo.input == Input::Search && std::string(algo.name) == "binary search") {
+        // Sorted from the start: increasing by random gaps
+        int64_t v = 0;
+        for (auto &x : a) x = v += value(rng) % 4 + 1;
+    } else {
+        for (auto &x : a) x = value(rng);
+    }
+
+    if (algo.input == Input::Array) return startArray(algo, std::move(a));
+    if (algo.input == Input::Search) {
+        // Half of the lookups hit an element, half look for any number in range
+        std::vector<int64_t> targets(kLookups);
+        std::uniform_int_distribution<size_t> element(0, n - 1);
+        std::uniform_int_distribution<int64_t> any(1, std::max(range, a.empty() ? 1 : a.back()));
+        for (size_t i = 0; i < kLookups; ++i) targets[i] = (i % 2 && n) ? a[element(rng)] : any(rng);
+        return startSearch(algo, std::move(a), std::move(targets));
+    }
+    std::vector<TreeTrace::Op> ops;
+    ops.reserve(n);
+    for (auto x : a) ops.push_back({true, x});
+    return std::unique_ptr<AlgorithmTrace>(new TreeTrace(std::move(ops), std::string(algo.name) == "avl"));
+}
+
+std::unique_ptr<AlgorithmTrace> Algorithms::start(const Info &algo, const std::string &input, std::string &error) {
+    std::string text = input;
+    std::replace(text.begin(), text.end(), ',', ' ');
+    std::vector<std::string> tokens;
+    std::istringstream ss(text);
+    for (std::string t; ss >> t;) tokens.push_back(t);
+
+    int64_t n = 0;
+    if (tokens.size() == 2 && tokens[0] == "random") {
+        if (!parseNumber(tokens[1], n) || n < 1 || (size_t)n > kMaxRandom) {
+            error = "random takes a size from 1 to " + std::to_string(kMaxRandom) + ".";
+            return nullptr;
+        }
+        return random(algo, (size_t)n, std::random_device{}());
+    }
+    if (tokens.empty()) {
+        error = "What should I run it on? For example: show " + std::string(algo.name) + " on " + usage(algo);
+        return nullptr;
+    }
+
+    if (algo.input == Input::Graph) {
+        Graph g;
+        std::map<int64_t, int32_t> ids;  // label -> vertex
+        auto vertex = [&](int64_t label) {
+            auto it = ids.find(label);
+            if (it != ids.end()) return it->second;
+            int32_t id = (int32_t)g.labels_.size();
+            ids[label] = id;
+            g.labels_.push_back(label);
+            g.adj_.emplace_back();
+            return id;
+        };
+        bool haveSource = false;
+        int64_t source = 0;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            const std::string &t = tokens[i];
+            if ((t == "from" || t == "start") && i + 1 < tokens.size() && parseNumber(tokens[i + 1], source)) {
+                haveSource = true;
+                ++i;
+                continue;
+            }
+            // u-v or u-v:weight
+            size_t dash = t.find('-', 1), colon = t.find(':');
+            int64_t u, v, w = 1;
+            if (dash == std::string::npos || !parseNumber(t.substr(0, dash), u) ||
+                !parseNumber(t.substr(dash + 1, colon == std::string::npos ? std::string::npos : colon - dash - 1), v) ||
+                (colon != std::string::npos && !parseNumber(t.substr(colon + 1), w)) || u < 0 || v < 0) {
+                error = "I read graphs as edges like 0-1 (or 0-1:4 with a weight), e.g. show " +
+                        std::string(algo.name) + " on " + usage(algo);
+                return nullptr;
+            }
+            if (w < 0) {
+                error = "Edge weights must not be negative.";
+                return nullptr;
+            }
+            int32_t a = vertex(u), b = vertex(v);
+            g.adj_[(size_t)a].push_back({b, w});
+            if (a != b) g.adj_[(size_t)b].push_back({a, w});
+        }
+        if (g.adj_.empty()) {
+            error = "Give me at least one edge, e.g. show " + std::string(algo.name) + " on " + usage(algo);
+            return nullptr;
+        }
+        if (haveSource) {
+            auto it = ids.find(source);
+            if (it == ids.end()) {
+                error = "Vertex " + std::to_string(source) + " is not on any edge.";
+                return nullptr;
+            }
+            g.source_ = it->second;
+        }
+        return startGraph(algo, std::move(g));
+    }
+
+    std::vector<int64_t> values, targets;
+    std::vector<TreeTrace::Op> ops;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string &t = tokens[i];
+        int64_t v;
+        if (parseNumber(t, v)) {
+            values.push_back(v);
+            ops.push_back({true, v});
+            continue;
+        }
+        bool keyword = algo.input == Input::Search ? (t == "find" || t == "for" || t == "target")
+                     : algo.input == Input::Keys   ? (t == "delete" || t == "del" || t == "remove")
+                                                   : false;
+        if (keyword && i + 1 < tokens.size() && parseNumber(tokens[i + 1], v)) {
+            targets.push_back(v);
+            ops.push_back({false, v});
+            ++i;
+            continue;
+        }
+        error = "I can only run it on whole numbers, e.g. show " + std::string(algo.name) + " on " + usage(algo);
+        return nullptr;
+    }
+
+    if (algo.input == Input::Keys)
+        return std::unique_ptr<AlgorithmTrace>(new TreeTrace(std::move(ops), std::string(algo.name) == "avl"));
+    if (values.empty()) {
+        error = "Give me some numbers, e.g. show " + std::string(algo.name) + " on " + usage(algo);
+        return nullptr;
+    }
+    if (algo.input == Input::Search) {
+        if (targets.empty()) {
+            error = "Which number should I look for? e.g. show " + std::string(algo.name) + " on " + usage(algo);
+            return nullptr;
+        }
+        return startSearch(algo, std::move(values), std::move(targets));
+    }
+    return startArray(algo, std::move(values));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One step of a running algorithm: small and fixed-size, so millions can stream through.
+// What a, b, x and y hold depends on the algorithm; the trace that produced a step describes it.
+struct TraceStep {
+    enum Kind : uint8_t {
+        Compare, Swap, Write, Pivot,         // arrays
+        Found, NotFound, Hash,               // searches and tree lookups
+        Insert, Remove, RotateLeft, RotateRight,  // trees
+        Visit, Discover, Finish, Relax,      // graphs
+        kKinds
+    };
+    Kind kind;
+    int64_t a, b;  // positions: array indices, tree keys, vertices
+    int64_t x, y;  // values at them, distances, edge weights
+};
+
+// An algorithm from the library, run one step at a time.
+// Steps are produced on demand and never stored: next() resumes the algorithm where the last
+// step left it, so a trace over 10^6 elements costs the input plus a little state, however
+// many steps it has.
+class AlgorithmTrace {
+public:
+    virtual ~AlgorithmTrace() = default;
+
+    // Run on to the next step; false once the algorithm has finished
+    bool next(TraceStep &step) {
+        if (!resume(step)) return false;
+        ++counts_[step.kind];
+        ++steps_;
+        return true;
+    }
+    // Run up to maxSteps more steps without describing them; true if the algorithm finished
+    bool finish(uint64_t maxSteps = UINT64_MAX);
+
+    virtual std::string describe(const TraceStep &step) const = 0;
+    // The data as it stands (array, tree, visited set, distances), or "" when too large to print
+    virtual std::string snapshot() const = 0;
+    std::string summary() const;  // step counts by kind: "14 compares, 6 swaps"
+
+    uint64_t steps() const { return steps_; }
+    uint64_t count(TraceStep::Kind kind) const { return counts_[kind]; }
+
+protected:
+    // Produce the next step. Implementations are resumable functions: line_ records where
+    // the last step was returned, and state that lives across steps is kept in members.
+    virtual bool resume(TraceStep &step) = 0;
+    int line_ = 0;
+
+private:
+    uint64_t steps_ = 0;
+    std::array<uint64_t, TraceStep::kKinds> counts_{};
+};
+
+// The algorithms the bot can step through and time, and how their input is given
+class Algorithms {
+public:
+    enum class Input {
+        Array,   // numbers: show quicksort on 5 3 8 1
+        Search,  // numbers and the targets to look up: show binary search on 1 3 5 8 find 5 find 4
+        Keys,    // keys to insert, "delete k" to remove: show avl on 5 3 8 1 delete 3
+        Graph,   // edges, optionally weighted: show dijkstra on 0-1:4 0-2:1 2-1:2 from 0
+    };
+    struct Info {
+        const char *name;        // as used in commands
+        const char *title;
+        const char *aliases;     // other spellings, separated by '|' and compared without spaces
+        Input input;
+        const char *complexity;  // as taught
+    };
+
+    static const size_t kMaxRandom = 10000000;  // largest "random <n>" input
+    static const size_t kLookups = 1000;        // targets a random search input looks up
+
+    static const std::vector<Info> &all();
+    static const Info *find(const std::string &name);  // nullptr if unknown
+
+    // Parse the input written after "on" (or "random <n>"), then start the algorithm on it.
+    // Returns nullptr and sets error when the input does not fit the algorithm.
+    static std::unique_ptr<AlgorithmTrace> start(const Info &algo, const std::string &input, std::string &error);
+    // Start on n random elements (a random connected graph with n vertices; a search gets
+    // kLookups targets, half of them present), e.g. for benchmarks
+    static std::unique_ptr<AlgorithmTrace> random(const Info &algo, size_t n, uint32_t seed);
+    static const char *usage(const Info &algo);  // an example command
+};
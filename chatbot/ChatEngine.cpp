@@ -1,509 +1,1064 @@
-
-#include "ChatEngine.h"
-#include "NLP.h"
-#include <iostream>
-#include <sstream>
-#include <vector>
-#include <thread>
-#include <chrono>
-#include <algorithm>
-#include <fstream>
-#include <cctype>
-#ifdef _WIN32
-#include <windows.h>
-#endif
-
-ChatEngine::ChatEngine(DataManager &dm) : dm_(dm), quiz_(dm.getBasePath()) {}
-
-static void setColor(int colorCode) {
-#ifdef _WIN32
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(h, colorCode);
-#endif
-}
-
-static void resetColor() {
-#ifdef _WIN32
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(h, 7);
-#endif
-}
-
-void ChatEngine::typePrint(const std::string &s, int msDelay) {
-    // If string very large, print without typing effect
-    if (s.size() > 1500) {
-        setColor(11); // Cyan
-        std::cout << s << std::endl;
-        resetColor();
-        return;
-    }
-
-    // Print with small delay to mimic typing
-    setColor(11); // Cyan
-    for (char c : s) {
-        std::cout << c << std::flush;
-#ifdef _WIN32
-        Sleep(msDelay);
-#else
-        std::this_thread::sleep_for(std::chrono::milliseconds(msDelay));
-#endif
-    }
-    std::cout << std::endl;
-    resetColor();
-}
-
-static std::string lower(const std::string &s) {
-    std::string t = s;
-    std::transform(t.begin(), t.end(), t.begin(), ::tolower);
-    return t;
-}
-
-// Helper to normalize string for FAQ matching (remove spaces, punctuation)
-static std::string normalizeFAQ(const std::string &s) {
-    std::string result;
-    for (char c : s) {
-        if (std::isalnum(c)) {
-            result += std::tolower(c);
-        }
-    }
-    return result;
-}
-
-// Longest common substring length (used for fuzzy FAQ matching)
-static int longestCommonSubstring(const std::string &a, const std::string &b) {
-    if (a.empty() || b.empty()) return 0;
-    int n = (int)a.size();
-    int m = (int)b.size();
-    std::vector<std::vector<int>> dp(n+1, std::vector<int>(m+1, 0));
-    int best = 0;
-    for (int i = 1; i <= n; ++i) {
-        for (int j = 1; j <= m; ++j) {
-            if (a[i-1] == b[j-1]) {
-                dp[i][j] = dp[i-1][j-1] + 1;
-                if (dp[i][j] > best) best = dp[i][j];
-            }
-        }
-    }
-    return best;
-}
-
-std::string ChatEngine::getContextTopic() {
-    if (!topicStack_.empty()) {
-        return topicStack_.top();
-    }
-    return "unknown";
-}
-
-void ChatEngine::saveSessionProgress() {
-    if (sessionTopics_.empty()) return;
-    
-    std::cout << "\nWould you like to save your session progress? (yes/no): ";
-    std::string saveChoice;
-    std::getline(std::cin, saveChoice);
-    
-    if (saveChoice == "yes" || saveChoice == "y" || saveChoice == "sure" || saveChoice == "yep") {
-        std::cout << "Enter your username: ";
-        std::string username;
-        std::getline(std::cin, username);
-        
-        std::string userPath = dm_.getBasePath() + "\\user\\topics_history.txt";
-
-        // Append a new session line for the user. We intentionally append to preserve history.
-        std::ofstream outFile(userPath, std::ios::app);
-        if (!outFile) {
-            std::cout << "Unable to open topics history file for writing: " << userPath << "\n";
-            return;
-        }
-
-        outFile << username << "|sessions:";
-        for (size_t i = 0; i < sessionTopics_.size(); ++i) {
-            if (i > 0) outFile << ",";
-            outFile << sessionTopics_[i];
-        }
-        outFile << "\n";
-        outFile.close();
-        
-        setColor(2); // Green
-        std::cout << "Session progress saved!\n";
-        resetColor();
-    }
-}
-
-void ChatEngine::start() {
-    typePrint("Hi! I'm your DSA study assistant.");
-    typePrint("What do you want to study today? (e.g., bst, queue, linked_list, graphs, binary_tree, sorting...)");
-
-    while (true) {
-        std::cout << "\nYou: ";
-        setColor(7); // White
-        std::string input;
-        std::getline(std::cin, input);
-        resetColor();
-        
-        if (!std::cin) break;
-
-        // Normalize input early
-        input = lower(input);
-
-        // Exit synonyms
-        if (input == "exit" || input == "quit" || input == "bye" || input == "stop"|| input == "end" || input == "end session") {
-            saveSessionProgress();
-            typePrint("Bye! Keep practicing.");
-            // Empty the stack
-            while (!topicStack_.empty()) topicStack_.pop();
-            break;
-        }
-        
-        // Check for progress display request
-        if (input.find("progress") != std::string::npos || input.find("show progress") != std::string::npos) {
-            std::cout << "Enter your username to view progress: ";
-            std::string username;
-            std::getline(std::cin, username);
-            quiz_.displayProgress(username);
-            continue;
-        }
-
-        auto parsed = parseIntentAndTopic(input);
-        std::string intent = parsed.first;
-        std::string topic = parsed.second;
-
-        // If multiple topics were detected (joined with '|'), pick the most specific one
-        auto chooseBestTopic = [&](const std::string &topicStr, const std::string &origInput) {
-            if (topicStr.find('|') == std::string::npos) return topicStr;
-            // split
-            std::vector<std::string> parts;
-            std::istringstream pss(topicStr);
-            std::string seg;
-            while (std::getline(pss, seg, '|')) if (!seg.empty()) parts.push_back(seg);
-
-            // If the original input explicitly mentions a short name, prefer that
-            for (auto &t : parts) {
-                // The stored topic keys use underscores (e.g., "linked_list") while user input
-                // typically uses spaces ("linked list"). Check both forms when matching.
-                if (origInput.find(t) != std::string::npos) return t;
-                std::string t_space = t;
-                for (auto &c : t_space) if (c == '_') c = ' ';
-                if (origInput.find(t_space) != std::string::npos) return t;
-            }
-
-            // Prefer more specific topics if present
-            if (std::find(parts.begin(), parts.end(), std::string("avl_tree")) != parts.end()) return std::string("avl_tree");
-            if (std::find(parts.begin(), parts.end(), std::string("bst")) != parts.end()) return std::string("bst");
-            if (std::find(parts.begin(), parts.end(), std::string("binary_tree")) != parts.end()) return std::string("binary_tree");
-
-            // default to first
-            return parts.empty() ? std::string("unknown") : parts[0];
-        };
-
-        // pick best topic now
-        std::string chosenTopic = (topic == "unknown") ? topic : chooseBestTopic(topic, input);
-        topic = chosenTopic;
-
-        
-        // If topic not detected but context exists, use top of stack
-        if (topic == "unknown" && !topicStack_.empty()) {
-            topic = topicStack_.top();
-            // For ambiguous requests like "explain in detail", use context
-            if (intent == "unknown" || intent == "detail") {
-                intent = "detail";
-            }
-        }
-
-        if (intent == "unknown" && topic == "unknown") {
-            typePrint("Hmm... I didn't quite understand. Try something like:");
-            typePrint("  teach me bst");
-            typePrint("  quiz me on queues");
-            typePrint("  give example of stack");
-            typePrint("  difference between array and linked list");
-            continue;
-        }
-
-        // Push detected topic to stack if new
-        if (topic != "unknown") {
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-            
-            // Only push if different from top
-            if (topicStack_.empty() || topicStack_.top() != mainTopic) {
-                topicStack_.push(mainTopic);
-                // Add to session topics if not already there
-                if (std::find(sessionTopics_.begin(), sessionTopics_.end(), mainTopic) == sessionTopics_.end()) {
-                    sessionTopics_.push_back(mainTopic);
-                }
-            }
-        }
-
-        if (intent == "learn" || intent == "definition") {
-            if (topic == "unknown") {
-                typePrint("Sure, which topic? (bst, queue, linked_list, array, binary_tree, sorting...)");
-                continue;
-            }
-
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-
-            std::string section = dm_.loadTopicSection(mainTopic, "definition");
-            if (section.empty()) section = dm_.loadTopicContent(mainTopic);
-
-            // DEBUG: 
-            // std::cerr << "[DEBUG] learn block: intent=" << intent << ", topic=" << mainTopic << ", section_len=" << section.length() << "\n";
-
-            // Show only a concise definition (first paragraph)
-            std::istringstream ss(section);
-            std::string line, out;
-            while (std::getline(ss, line)) {
-                if (!line.empty()) { out = line; break; }
-            }
-            if (out.empty()) out = section;
-            typePrint(out, 1);
-            typePrint("Do you want more detail, pseudocode, example, or a quiz?");
-            continue;
-        }
-
-        if (intent == "detail") {
-            if (topic == "unknown") {
-                typePrint("Which topic would you like more detail on?");
-                continue;
-            }
-            
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-            
-            // Output complete topic file
-            std::string content = dm_.loadTopicContent(mainTopic);
-            typePrint(content, 1);
-            continue;
-        }
-
-        if (intent == "quiz") {
-            if (topic == "unknown") {
-                typePrint("Which topic should I quiz you on?");
-                continue;
-            }
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-            quiz_.runQuiz(mainTopic);
-            continue;
-        }
-
-        if (intent == "example" || intent == "pseudocode") {
-            if (topic == "unknown") {
-                typePrint("Which topic are you asking about?");
-                continue;
-            }
-
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-
-            std::string section = dm_.loadTopicSection(mainTopic, intent == "example" ? "example" : "pseudocode");
-            if (section.empty()) {
-                typePrint("I couldn't find a specific section. Here's a summary:");
-                std::string sum = dm_.loadTopicSection(mainTopic, "definition");
-                if (sum.empty()) sum = dm_.loadTopicContent(mainTopic);
-                typePrint(sum, 1);
-            } else {
-                // If user asked for specific pseudocode (e.g., preorder/inorder), try to extract only that part
-                if (intent == "pseudocode") {
-                    std::vector<std::string> subkeys = {"preorder", "inorder", "postorder", "search", "insert", "delete", "traversal"};
-                    std::string foundSub;
-                    for (auto &k : subkeys) if (input.find(k) != std::string::npos) { foundSub = k; break; }
-
-                    if (!foundSub.empty()) {
-                        // Look through the full topic content for labeled pseudocode blocks and return
-                        // the single block whose heading or body contains the requested subkey.
-                        std::string full = dm_.loadTopicContent(mainTopic);
-                        std::istringstream css(full);
-                        std::string line;
-                        std::string curHeading;
-                        std::string curBody;
-                        std::vector<std::pair<std::string,std::string>> blocks;
-                        while (std::getline(css, line)) {
-                            if (!line.empty() && line.back() == '\r') line.pop_back();
-                            std::string low = lower(line);
-                            if (low.find("pseudocode:") == 0) {
-                                if (!curHeading.empty()) {
-                                    blocks.push_back({curHeading, curBody});
-                                    curBody.clear();
-                                }
-                                // heading text after label
-                                size_t col = line.find(':');
-                                curHeading = (col==std::string::npos) ? line : line.substr(col+1);
-                                // trim
-                                size_t st = curHeading.find_first_not_of(" \t");
-                                if (st!=std::string::npos) curHeading = curHeading.substr(st);
-                            } else if (!curHeading.empty()) {
-                                if (line.empty()) {
-                                    // end of this pseudocode block
-                                    blocks.push_back({curHeading, curBody});
-                                    curHeading.clear(); curBody.clear();
-                                } else {
-                                    if (!curBody.empty()) curBody += "\n";
-                                    curBody += line;
-                                }
-                            }
-                        }
-                        if (!curHeading.empty()) blocks.push_back({curHeading, curBody});
-
-                        bool printed = false;
-                        for (auto &b : blocks) {
-                            std::string lowh = lower(b.first);
-                            std::string lowb = lower(b.second);
-                            if (lowh.find(foundSub) != std::string::npos || lowb.find(foundSub) != std::string::npos) {
-                                std::string out = b.first + "\n" + b.second;
-                                size_t st = out.find_first_not_of("\n \t");
-                                if (st!=std::string::npos) out = out.substr(st);
-                                typePrint(out, 1);
-                                printed = true;
-                                break;
-                            }
-                        }
-                        if (!printed) {
-                            // fallback to the original section if no specific block found
-                            typePrint(section, 1);
-                        }
-                    } else {
-                        typePrint(section, 1);
-                    }
-                } else {
-                    typePrint(section, 1);
-                }
-            }
-            continue;
-        }
-
-        if (intent == "difference") {
-            if (topic == "unknown") {
-                typePrint("Which two topics do you want to compare? e.g. 'difference between array and linked list'");
-                continue;
-            }
-            std::string t1 = topic, t2;
-            size_t sep = t1.find('|');
-            if (sep != std::string::npos) {
-                t2 = t1.substr(sep+1);
-                t1 = t1.substr(0, sep);
-            }
-            if (t2.empty()) {
-                // Fallback: try splitting the original input around ' and ' or ' vs ' to detect two topics
-                size_t andPos = input.find(" and ");
-                size_t vsPos = input.find(" vs ");
-                size_t splitPos = std::string::npos;
-                if (andPos != std::string::npos) splitPos = andPos;
-                else if (vsPos != std::string::npos) splitPos = vsPos;
-
-                if (splitPos != std::string::npos) {
-                    std::string left = input.substr(0, splitPos);
-                    std::string right = input.substr(splitPos + ((andPos!=std::string::npos) ? 5 : 4));
-                    auto lpair = parseIntentAndTopic(left);
-                    auto rpair = parseIntentAndTopic(right);
-                    if (lpair.second != "unknown" && rpair.second != "unknown") {
-                        t1 = lpair.second;
-                        t2 = rpair.second;
-                    }
-                }
-
-                if (t2.empty()) {
-                    typePrint("Please mention two topics to compare (e.g., 'array and linked list').");
-                    continue;
-                }
-            }
-
-            std::string def1 = dm_.loadTopicSection(t1, "definition");
-            std::string def2 = dm_.loadTopicSection(t2, "definition");
-            if (def1.empty()) def1 = dm_.loadTopicContent(t1);
-            if (def2.empty()) def2 = dm_.loadTopicContent(t2);
-
-            auto firstNonEmpty = [](const std::string &s){
-                std::istringstream ss(s); std::string l; while (std::getline(ss,l)) if (!l.empty()) return l; return std::string(); };
-            std::string c1 = firstNonEmpty(def1);
-            std::string c2 = firstNonEmpty(def2);
-
-            typePrint(t1 + ": " + (c1.empty() ? "(no short definition)" : c1));
-            typePrint(t2 + ": " + (c2.empty() ? "(no short definition)" : c2));
-            typePrint("Short difference:");
-            
-            if ((t1=="array" && t2=="linked_list") || (t2=="array" && t1=="linked_list")) {
-                typePrint("Arrays use contiguous memory and offer O(1) index access; linked lists use dynamic nodes and allow O(1) insert/delete at head but O(n) access.");
-            } else if ((t1=="stack" && t2=="queue") || (t2=="stack" && t1=="queue")) {
-                typePrint("Stacks follow LIFO; queues follow FIFO. Stack removes from top; queue removes from front.");
-            } else if ((t1=="bst" && t2=="binary_tree") || (t2=="bst" && t1=="binary_tree")) {
-                typePrint("A BST is a binary tree with ordering property (left < node < right). Not all binary trees are BSTs.");
-            } else if ((t1=="bst" && t2=="avl_tree") || (t2=="bst" && t1=="avl_tree")) {
-                typePrint("AVL is a self-balancing BST. Both follow BST rules but AVL maintains strict height balance for guaranteed O(log n) operations.");
-            } else if ((t1=="queue" && t2=="deque") || (t2=="queue" && t1=="deque")) {
-                typePrint("A queue inserts at rear and deletes at front; a deque allows insert/delete at both ends.");
-            } else if ((t1=="hash_table" && t2=="binary_search") || (t2=="hash_table" && t1=="binary_search")) {
-                typePrint("Hash table average search is O(1); binary search is O(log n) but requires sorted array.");
-            } else if ((t1=="array" && t2=="vector") || (t2=="array" && t1=="vector")) {
-                typePrint("Arrays are fixed-size; vectors are dynamic arrays that resize automatically.");
-            } else if ((t1=="vector" && t2=="linked_list") || (t2=="vector" && t1=="linked_list")) {
-                typePrint("Vectors give O(1) random access; linked lists give O(1) insert/delete but O(n) access.");
-            } else if ((t1=="graph" && t2=="tree") || (t2=="graph" && t1=="tree")) {
-                typePrint("A tree is a special graph with no cycles and a single root; graphs may have cycles and no root.");
-            } else if ((t1=="dfs" && t2=="bfs") || (t2=="dfs" && t1=="bfs")) {
-                typePrint("DFS goes deep first using a stack; BFS explores level-wise using a queue.");
-            } else if ((t1=="heap" && t2=="bst") || (t2=="heap" && t1=="bst")) {
-                typePrint("A heap maintains heap-order (parent > children or vice versa); a BST keeps keys sorted based on left < root < right.");
-            } else {
-                typePrint("(If you want a detailed comparison, ask for more details of both topics one by one,as i dont have one liner difference for it.)");
-            }
-            
-            continue;
-        }
-
-         // Immediately attempt FAQ-first matching for detected topic.
-        if (topic != "unknown") {
-            std::string mainTopic = topic;
-            size_t sep = mainTopic.find('|');
-            if (sep != std::string::npos) mainTopic = mainTopic.substr(0, sep);
-
-            std::string faqSection = dm_.loadTopicSection(mainTopic, "FAQ");
-            if (!faqSection.empty()) {
-                std::string normalizedInput = normalizeFAQ(input);
-
-                std::istringstream ss(faqSection);
-                std::string line;
-                std::string curQ, curA;
-                std::string bestAnswer;
-                int bestScore = 0;
-
-                while (std::getline(ss, line)) {
-                    if (line.rfind("Q:", 0) == 0) {
-                        curQ = line.substr(2);
-                    } else if (line.rfind("A:", 0) == 0) {
-                        curA = line.substr(2);
-                        if (!curQ.empty()) {
-                            std::string normalizedQ = normalizeFAQ(curQ);
-                            int lcs = longestCommonSubstring(normalizedInput, normalizedQ);
-
-                            // If input or question contains the other, treat as strong match
-                            if (!normalizedQ.empty() && (normalizedQ.find(normalizedInput) != std::string::npos || normalizedInput.find(normalizedQ) != std::string::npos)) {
-                                lcs = std::max((int)normalizedInput.size(), (int)normalizedQ.size());
-                            }
-
-                            // If at least half of either string matches, consider it good
-                            int threshold = std::max(1, std::min((int)normalizedQ.size()/2, (int)normalizedInput.size()/2));
-                            if (lcs >= threshold && lcs > bestScore) {
-                                bestScore = lcs;
-                                bestAnswer = curA;
-                            }
-                        }
-                        curQ.clear(); curA.clear();
-                    }
-                }
-
-                if (bestScore > 0 && !bestAnswer.empty()) {
-                    typePrint(bestAnswer, 1);
-                    continue;
-                }
-            }
-        }
-        
-
-        typePrint("Sorry, I couldn't handle that request yet. Try 'explain <topic>' or 'quiz <topic>'.");
-    }
-}
+
+#include "ChatEngine.h"
+#include "NLP.h"
+#include "ResponseCache.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cctype>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+ChatEngine::ChatEngine(DataManager &dm, const std::string &sessionId, std::ostream &out)
+    : dm_(dm), out_(out), quiz_([&dm]() { return dm.quizzes(); }, dm.analytics(), dm.progress(), out), sessionId_(sessionId) {
+    quiz_.setCheckpointHook([this]() { checkpointSession(); });
+}
+
+ChatEngine::~ChatEngine() {
+    // Nobody is left to read the report
+    benchmarkCancel_ = true;
+    if (benchmark_.valid()) benchmark_.wait();
+}
+
+static void setColor(int colorCode) {
+#ifdef _WIN32
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    SetConsoleTextAttribute(h, colorCode);
+#endif
+}
+
+static void resetColor() {
+#ifdef _WIN32
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    SetConsoleTextAttribute(h, 7);
+#endif
+}
+
+void ChatEngine::typePrint(const std::string &s, int msDelay) {
+    firstByte();
+    // If string very large (or output is not a console), print without typing effect
+    if (!typing_ || s.size() > 1500) {
+        setColor(11); // Cyan
+        out_ << s << std::endl;
+        resetColor();
+        return;
+    }
+
+    // Print with small delay to mimic typing
+    auto typingStarted = std::chrono::steady_clock::now();
+    setColor(11); // Cyan
+    for (char c : s) {
+        out_ << c << std::flush;
+#ifdef _WIN32
+        Sleep(msDelay);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(msDelay));
+#endif
+    }
+    out_ << std::endl;
+    resetColor();
+    typingUs_ += std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - typingStarted).count();
+}
+
+void ChatEngine::firstByte() {
+    if (turn_.firstByteUs) return;
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - turnStarted_).count() - typingUs_;
+    turn_.firstByteUs = (uint32_t)std::max<int64_t>(1, us);
+}
+
+// Start of the first line at or after pos with more than whitespace on it; text.size() if none
+static size_t skipBlankLines(const std::string &text, size_t pos) {
+    for (size_t p = pos; p < text.size(); ++p) {
+        char c = text[p];
+        if (c == '\n') pos = p + 1;
+        else if (c != ' ' && c != '\t' && c != '\r') return pos;
+    }
+    return text.size();
+}
+
+void ChatEngine::streamChunk() {
+    if (!stream_) return;
+    const std::string &text = *stream_;
+    // Blank lines between chunks are skipped, so no chunk is only line breaks
+    streamPos_ = skipBlankLines(text, streamPos_);
+    if (streamPos_ < text.size()) {
+        size_t end = std::min(text.size(), streamPos_ + kStreamChunk);
+        if (end < text.size()) {
+            // End after the last line break in the chunk, or at least not inside a UTF-8 character
+            size_t nl = text.rfind('\n', end - 1);
+            if (nl != std::string::npos && nl >= streamPos_) end = nl + 1;
+            else while (end > streamPos_ + 1 && ((unsigned char)text[end] & 0xC0) == 0x80) --end;
+        }
+
+        // Straight from the pooled text: nothing is copied, however large the topic file
+        size_t shown = text.find_last_not_of(" \t\r\n", end - 1) + 1;  // > streamPos_: it starts a non-blank line
+        firstByte();
+        setColor(11); // Cyan
+        out_.write(text.data() + streamPos_, (std::streamsize)(shown - streamPos_));
+        out_ << '\n';
+        resetColor();
+        streamPos_ = skipBlankLines(text, end);  // nothing but blank lines left ends the stream now
+    }
+    if (streamPos_ >= text.size()) {
+        out_ << std::flush;
+        stream_.reset();
+        streamTopic_.clear();
+        return;
+    }
+    out_ << "-- " << streamPos_ * 100 / text.size() << "% of " << streamTopic_
+         << " so far; say 'more' to continue --" << std::endl;
+}
+
+static std::string lower(const std::string &s) {
+    std::string t = s;
+    std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+    return t;
+}
+
+// Helper to normalize string for FAQ matching (remove spaces, punctuation)
+static std::string normalizeFAQ(const std::string &s) {
+    std::string result;
+    for (char c : s) {
+        if (std::isalnum(c)) {
+            result += std::tolower(c);
+        }
+    }
+    return result;
+}
+
+// Longest common substring length (used for fuzzy FAQ matching)
+static int longestCommonSubstring(const std::string &a, const std::string &b) {
+    if (a.empty() || b.empty()) return 0;
+    int n = (int)a.size();
+    int m = (int)b.size();
+    std::vector<std::vector<int>> dp(n+1, std::vector<int>(m+1, 0));
+    int best = 0;
+    for (int i = 1; i <= n; ++i) {
+        for (int j = 1; j <= m; ++j) {
+            if (a[i-1] == b[j-1]) {
+                dp[i][j] = dp[i-1][j-1] + 1;
+                if (dp[i][j] > best) best = dp[i][j];
+            }
+        }
+    }
+    return best;
+}
+
+void ChatEngine::syncTopics() {
+    std::shared_ptr<const TopicRegistry> latest = dm_.topics();
+    if (latest == topics_) return;
+    if (topics_) {
+        std::vector<int> ids(topics_->size());
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = latest->find(topics_->topic((int)i).key);
+        context_.remap(ids);
+    }
+    topics_ = std::move(latest);
+}
+
+void ChatEngine::pushTopic(const std::string &topic) {
+    context_.visit(topics().find(topic));
+}
+
+std::string ChatEngine::getContextTopic() {
+    return topicName(context_.resolve());
+}
+
+std::vector<std::string> ChatEngine::sessionTopics() const {
+    std::vector<std::string> names;
+    for (int id : context_.visitOrder()) names.push_back(topicName(id));
+    return names;
+}
+
+bool ChatEngine::navigate(const std::string &input) {
+    if (input == "back" || input == "go back" || input == "previous topic") {
+        if (!context_.back()) {
+            typePrint(context_.size() ? "That was the first topic of this session." : "We haven't covered a topic yet.");
+            return true;
+        }
+        std::string hint = "'explain it' for more";
+        if (context_.previous() >= 0) hint += ", 'back' for " + topicName(context_.previous());
+        typePrint("Back to " + topicName(context_.current()) + ". (Say " + hint + ", or 'forward' to return to " +
+                  topicName(context_.next()) + ".)");
+        return true;
+    }
+    if (input == "forward" || input == "go forward") {
+        if (!context_.forward()) {
+            typePrint("There is nothing to go forward to. Say 'back' to revisit the previous topic.");
+            return true;
+        }
+        typePrint("Forward to " + topicName(context_.current()) + ".");
+        return true;
+    }
+    if (input == "history" || input == "topic history") {
+        if (!context_.size()) {
+            typePrint("We haven't covered a topic yet.");
+            return true;
+        }
+        std::string line = "Topics so far:";
+        for (int i = 0; i < context_.size(); ++i) {
+            std::string name = topicName(context_.topicAt(i));
+            line += i ? " > " : " ";
+            line += i == context_.position() ? "[" + name + "]" : name;
+        }
+        typePrint(line);
+        return true;
+    }
+    return false;
+}
+
+void ChatEngine::awaitReply(const std::string &prompt, std::function<void(const std::string &)> next) {
+    out_ << prompt;
+    pending_ = std::move(next);
+}
+
+void ChatEngine::saveSessionProgress(std::function<void()> done) {
+    if (context_.visitOrder().empty()) return done();
+    
+    awaitReply("\nWould you like to save your session progress? (yes/no): ", [this, done](const std::string &saveChoice) {
+        if (!(saveChoice == "yes" || saveChoice == "y" || saveChoice == "sure" || saveChoice == "yep")) return done();
+
+        awaitReply("Enter your username: ", [this, done](const std::string &username) {
+            username_ = username;
+        
+            // Append a new session line for the user. We intentionally append to preserve history.
+            if (!dm_.progress().appendSession(username, sessionTopics())) {
+                out_ << "Unable to open topics history file for writing: " << dm_.progress().sessionPath().string() << "\n";
+                return done();
+            }
+        
+            setColor(2); // Green
+            out_ << "Session progress saved!\n";
+            resetColor();
+            done();
+        });
+    });
+}
+
+TopicRecommender::Recommendation ChatEngine::recommendNext(const std::string &current) {
+    if (!quiz_.lastUsername().empty()) username_ = quiz_.lastUsername();
+
+    // Topics seen this session plus any saved history for the known user
+    std::vector<std::string> visited = sessionTopics();
+    LearningAnalytics &analytics = dm_.analytics();
+    if (!username_.empty()) analytics.studiedTopics(username_, visited);
+
+    std::string user = username_;
+    return dm_.recommender().recommend(visited, [&](const std::string &t) {
+        return user.empty() ? -1.0 : analytics.topicMean(user, t);
+    }, current);
+}
+
+void ChatEngine::checkpointSession() {
+    SessionState state;
+    // The history up to the current topic; anything ahead of it is not worth a restore
+    for (int i = 0; i <= context_.position() && i < context_.size(); ++i)
+        state.topicStack.push_back(topicName(context_.topicAt(i)));
+    state.sessionTopics = sessionTopics();
+    if (stream_) {
+        state.streamTopic = streamTopic_;
+        state.streamOffset = (uint32_t)streamPos_;
+    }
+
+    const QuizEngine::QuizState &q = quiz_.state();
+    if (q.active) {
+        state.quizActive = true;
+        state.quizTopic = q.topic;
+        state.quizDifficulty = q.difficulty;
+        state.quizIndex = (uint32_t)q.index;
+        state.quizScore = (uint32_t)q.score;
+        state.quizVariant = q.variant;
+    }
+
+    // In memory only; the store's writer thread puts it on disk
+    dm_.sessions().update(sessionId_, state);
+}
+
+bool ChatEngine::restoreSession() {
+    SessionState state;
+    if (!dm_.sessions().find(sessionId_, state)) return false;
+    syncTopics();
+    context_.clear();
+    for (auto &t : state.sessionTopics) context_.markVisited(topics().find(t));
+    for (auto &t : state.topicStack) pushTopic(t);
+
+    if (context_.current() >= 0) {
+        typePrint("Welcome back! We were talking about " + topicName(context_.current()) + ".");
+    }
+    ContentPool::Text text = state.streamTopic.empty() ? nullptr : dm_.topicText(state.streamTopic);
+    if (text && state.streamOffset < text->size()) {
+        stream_ = std::move(text);
+        streamTopic_ = state.streamTopic;
+        streamPos_ = state.streamOffset;
+        typePrint("You were reading about " + streamTopic_ + " (" +
+                  std::to_string(streamPos_ * 100 / stream_->size()) + "% done); say 'more' to go on.");
+    }
+    if (state.quizActive) {
+        typePrint("You have an unfinished " + state.quizDifficulty + " quiz on " + state.quizTopic +
+                  " (question " + std::to_string(state.quizIndex + 1) + "). Resume it? (yes/no)");
+        awaitReply("\nYou: ", [this, state](const std::string &reply) {
+            std::string choice = lower(reply);
+            if (choice == "yes" || choice == "y" || choice == "sure" || choice == "yep") {
+                QuizEngine::QuizState q;
+                q.active = true;
+                q.topic = state.quizTopic;
+                q.difficulty = state.quizDifficulty;
+                q.index = (int)state.quizIndex;
+                q.score = (int)state.quizScore;
+                q.variant = state.quizVariant;
+                quiz_.resumeQuiz(q);
+            }
+        });
+    }
+    checkpointSession();
+    return true;
+}
+
+void ChatEngine::greet() {
+    typePrint("Hi! I'm your DSA study assistant.");
+    typePrint("What do you want to study today? (e.g., bst, queue, linked_list, graphs, binary_tree, sorting...)");
+    restoreSession();
+}
+
+void ChatEngine::start() {
+    greet();
+
+    while (true) {
+        // Prompts and quiz questions print their own cue
+        if (!awaitingReply()) out_ << "\nYou: ";
+        setColor(7); // White
+        std::string input;
+        std::getline(std::cin, input);
+        resetColor();
+        
+        if (!std::cin) break;
+        if (!handleMessage(input)) break;
+    }
+}
+
+bool ChatEngine::handleMessage(const std::string &message) {
+    if (finished_) return false;
+    auto started = std::chrono::steady_clock::now();
+    turnStarted_ = started;
+    turn_.firstByteUs = 0;
+    turn_.session = dm_.course().empty() ? sessionId_ : dm_.course() + "/" + sessionId_;
+    turn_.input = message;
+    turn_.intent.clear();
+    turn_.topic.clear();
+    turn_.faqScore = -1.0f;
+    typingUs_ = 0;
+    dm_.progress().refresh();  // pick up results other processes saved
+    dm_.refreshCorpus();       // and topic files edited since they were read
+    corpusVersion_ = dm_.corpusVersion();  // before the registry, so a rebuild in between makes replies stale
+    syncTopics();
+    deliverBenchmark(false);
+    if (pending_) {
+        turn_.branch = "reply";
+        // The continuation may register the next one, so take it out first
+        auto next = std::move(pending_);
+        pending_ = nullptr;
+        next(message);
+    } else if (quiz_.waiting()) {
+        turn_.branch = "quiz answer";
+        quiz_.onMessage(message);
+    } else {
+        turn_.branch.clear();
+        // Handlers see exactly the text the response cache is keyed on, so a cached reply is
+        // the one they would give
+        handleTurn(ResponseCache::normalizeInput(message));
+    }
+
+    // Persist whatever this message changed before waiting for the next one
+    if (!finished_) checkpointSession();
+    // Time spent working out the reply, not the typing effect's pauses
+    turn_.latencyUs = (uint32_t)(std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - started).count() - typingUs_);
+    // Replies printed without typePrint (stats, traces, quiz questions) count as whole
+    if (!turn_.firstByteUs) turn_.firstByteUs = turn_.latencyUs;
+    EventLog::shared().record(turn_);
+    return !finished_;
+}
+
+void ChatEngine::endSession() {
+    saveSessionProgress([this]() {
+        typePrint("Bye! Keep practicing.");
+        context_.clear();
+        // The session ended normally, so there is nothing to restore next time
+        dm_.sessions().remove(sessionId_);
+        finished_ = true;
+    });
+}
+
+void ChatEngine::showProgress() {
+    awaitReply("Enter your username to view progress: ", [this](const std::string &username) {
+        username_ = username;
+        quiz_.displayProgress(username);
+    });
+}
+
+bool ChatEngine::showAlgorithm(const std::string &input) {
+    if (input == "show algorithms" || input == "list algorithms") {
+        turn_.branch = "algorithm";
+        out_ << "I can step through these (show <algorithm> on <input>, or on random <n>):\n";
+        for (auto &algo : Algorithms::all())
+            out_ << "  " << algo.name << " - " << algo.complexity << "   e.g. show " << algo.name << " on "
+                 << Algorithms::usage(algo) << "\n";
+        return true;
+    }
+
+    std::string rest;
+    for (const char *verb : {"show ", "visualize ", "trace ", "run "}) {
+        if (input.rfind(verb, 0) == 0) {
+            rest = input.substr(strlen(verb));
+            break;
+        }
+    }
+    size_t on = rest.find(" on ");
+    if (on == std::string::npos) return false;
+    const Algorithms::Info *algo = Algorithms::find(rest.substr(0, on));
+    if (!algo) return false;
+
+    turn_.branch = "algorithm";
+    std::string error;
+    auto trace = Algorithms::start(*algo, rest.substr(on + 4), error);
+    if (!trace) {
+        typePrint(error);
+        return true;
+    }
+    trace_ = std::move(trace);
+    stream_.reset();  // "more" and "next" step the trace from now on
+    traceSnapshot_.clear();
+    traceHasNext_ = trace_->next(traceNext_);
+    typePrint(std::string(algo->title) + ": " + algo->complexity + ". Step by step:");
+    stepTrace(kTraceBatch);
+    return true;
+}
+
+void ChatEngine::stepTrace(uint64_t steps) {
+    // traceNext_ is always one step ahead, so the last batch can say the algorithm is done
+    for (uint64_t i = 0; i < steps && traceHasNext_; ++i) {
+        out_ << "  " << trace_->steps() << ". " << trace_->describe(traceNext_);
+        // The data only when the step changed it
+        std::string snapshot = trace_->snapshot();
+        if (snapshot != traceSnapshot_) {
+            out_ << "   " << snapshot;
+            traceSnapshot_ = snapshot;
+        }
+        out_ << "\n";
+        traceHasNext_ = trace_->next(traceNext_);
+    }
+    if (traceHasNext_) {
+        out_ << "Type 'next' for more steps ('next 50' for more at once, 'next all' to run to the end).\n";
+        return;
+    }
+    out_ << "Done after " << trace_->steps() << " steps: " << trace_->summary() << ".";
+    std::string snapshot = trace_->snapshot();
+    if (!snapshot.empty()) out_ << " Result: " << snapshot;
+    out_ << "\n";
+    trace_.reset();
+}
+
+// "10000", "10k", "1m"
+static bool parseSize(const std::string &tok, size_t &n) {
+    if (tok.empty() || !std::isdigit((unsigned char)tok[0])) return false;
+    size_t used = 0;
+    unsigned long long v = std::stoull(tok, &used);
+    std::string suffix = tok.substr(used);
+    if (suffix == "k") v *= 1000;
+    else if (suffix == "m") v *= 1000000;
+    else if (!suffix.empty()) return false;
+    n = (size_t)v;
+    return true;
+}
+
+void ChatEngine::startBenchmark(const std::string &input) {
+    if (benchmark_.valid()) {
+        out_ << "Still measuring the last benchmark (" << benchmarkMeasured_.load() << " of " << benchmarkTotal_
+             << " timings done). Say 'results' to check on it.\n";
+        return;
+    }
+    std::string text = input.substr(std::string("benchmark").size());
+    std::replace(text.begin(), text.end(), ',', ' ');
+    std::vector<std::string> tokens;
+    std::istringstream ss(text);
+    for (std::string t; ss >> t;) tokens.push_back(t);
+
+    // Trailing numbers are the sizes, the rest names the algorithms
+    std::vector<size_t> sizes;
+    size_t n;
+    while (!tokens.empty() && tokens.back().size() < 12 && parseSize(tokens.back(), n)) {
+        if (n < 2 || n > Algorithms::kMaxRandom) {
+            out_ << "Sizes go from 2 to " << Algorithms::kMaxRandom << ".\n";
+            return;
+        }
+        sizes.push_back(n);
+        tokens.pop_back();
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    if (sizes.empty()) sizes = ComplexityLab::defaultSizes();
+    if (sizes.size() > 16) {
+        out_ << "That is a lot of sizes; 16 at most, please.\n";
+        return;
+    }
+
+    std::vector<const Algorithms::Info *> algos;
+    std::string name;
+    auto addAlgorithm = [&]() {
+        if (name.empty()) return true;
+        bool sorts = name == "sorts" || name == "sorting";
+        if (sorts || name == "searches" || name == "searching" || name == "lookups") {
+            for (auto &algo : Algorithms::all()) {
+                if (sorts ? algo.input == Algorithms::Input::Array && std::string(algo.name) != "heapify"
+                          : algo.input == Algorithms::Input::Search)
+                    algos.push_back(&algo);
+            }
+        } else if (const Algorithms::Info *algo = Algorithms::find(name)) {
+            algos.push_back(algo);
+        } else {
+            out_ << "I can't benchmark '" << name << "'. 'show algorithms' lists what I can run.\n";
+            return false;
+        }
+        name.clear();
+        return true;
+    };
+    for (auto &t : tokens) {
+        if (t == "vs" || t == "versus" || t == "and") {
+            if (!addAlgorithm()) return;
+        } else {
+            name += (name.empty() ? "" : " ") + t;
+        }
+    }
+    if (!addAlgorithm()) return;
+    if (algos.empty()) {
+        typePrint("Tell me what to time, for example:");
+        typePrint("  benchmark linear search vs binary search");
+        typePrint("  benchmark bubble sort vs merge sort 1000 2000 4000 8000");
+        typePrint("  benchmark sorts   /   benchmark searches");
+        return;
+    }
+    if (!ComplexityLab::reserve()) {
+        out_ << "Another conversation is running a benchmark right now; try again in a few seconds.\n";
+        return;
+    }
+
+    ComplexityLab::Options opt;
+    opt.sizes = sizes;
+    opt.budget = kBenchmarkBudget;
+    opt.seed = (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    opt.cancel = &benchmarkCancel_;
+    opt.measured = &benchmarkMeasured_;
+    benchmarkCancel_ = false;
+    benchmarkMeasured_ = 0;
+    benchmarkTotal_ = algos.size() * sizes.size();
+    // Timing runs on a worker thread, so this conversation (and the others a server runs) keep going
+    benchmark_ = std::async(std::launch::async, [algos, opt]() {
+        auto series = ComplexityLab::run(algos, opt);
+        ComplexityLab::release();
+        return ComplexityLab::table(series) + "\n" + ComplexityLab::plot(series);
+    });
+
+    std::string names;
+    for (size_t i = 0; i < algos.size(); ++i)
+        names += (i ? (i + 1 == algos.size() ? " and " : ", ") : "") + std::string(algos[i]->name);
+    typePrint("Timing " + names + " on " + std::to_string(sizes.size()) + " input sizes from " +
+              std::to_string(sizes.front()) + " to " + std::to_string(sizes.back()) + ", for at most " +
+              std::to_string(kBenchmarkBudget.count() / 1000) + " seconds.");
+    typePrint("Keep chatting: the results come with your next message once they are ready (or say 'results').");
+}
+
+void ChatEngine::deliverBenchmark(bool asked) {
+    if (!benchmark_.valid()) return;
+    if (benchmark_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (asked)
+            out_ << "Still measuring: " << benchmarkMeasured_.load() << " of " << benchmarkTotal_ << " timings done.\n";
+        return;
+    }
+    out_ << "Benchmark results:\n" << benchmark_.get() << "\n";
+}
+
+// Everything an intent needs is declared here; handleTurn() does the shared work (topic choice,
+// context, asking for a missing topic, loading the section) once and makes a single call
+constexpr ChatEngine::IntentHandler ChatEngine::kHandlers[(size_t)Intent::Count] = {
+    // intent              section        fallback      askTopic                                   context suggest handler
+    {Intent::Unknown,      nullptr,       nullptr,      nullptr,                                   true,  false, &ChatEngine::handleOther},
+    {Intent::Learn,        "definition",  nullptr,      "Sure, which topic? (bst, queue, linked_list, array, binary_tree, sorting...)",
+                                                                                                   true,  true,  &ChatEngine::handleLearn},
+    {Intent::Definition,   "definition",  nullptr,      "Sure, which topic? (bst, queue, linked_list, array, binary_tree, sorting...)",
+                                                                                                   true,  true,  &ChatEngine::handleLearn},
+    {Intent::Detail,       nullptr,       nullptr,      "Which topic would you like more detail on?", true, false, &ChatEngine::handleDetail},
+    {Intent::Example,      "example",     "definition", "Which topic are you asking about?",       true,  false, &ChatEngine::handleSection},
+    {Intent::Pseudocode,   "pseudocode",  "definition", "Which topic are you asking about?",       true,  false, &ChatEngine::handleSection},
+    {Intent::Quiz,         nullptr,       nullptr,      "Which topic should I quiz you on?",       true,  false, &ChatEngine::handleQuiz},
+    {Intent::Difference,   nullptr,       nullptr,      "Which two topics do you want to compare? e.g. 'difference between array and linked list'",
+                                                                                                   true,  false, &ChatEngine::handleDifference},
+    {Intent::Recommend,    nullptr,       nullptr,      nullptr,                                   true,  false, &ChatEngine::handleRecommend},
+    {Intent::Progress,     nullptr,       nullptr,      nullptr,                                   false, false, &ChatEngine::handleProgress},
+    {Intent::Exit,         nullptr,       nullptr,      nullptr,                                   false, false, &ChatEngine::handleExit},
+};
+
+constexpr bool ChatEngine::handlersInOrder() {
+    for (size_t i = 0; i < (size_t)Intent::Count; ++i)
+        if (kHandlers[i].intent != (Intent)i) return false;
+    return true;
+}
+
+void ChatEngine::handleTurn(const std::string &input) {
+    context_.beginTurn();
+    // Exit synonyms
+    if (input == "exit" || input == "quit" || input == "bye" || input == "stop"|| input == "end" || input == "end session") {
+        turn_.branch = "exit";
+        endSession();
+        return;
+    }
+    
+    if (input == "cache stats" || input == "session stats" || input == "log stats" || input == "content stats")
+        turn_.branch = "stats";
+
+    if (input == "cache stats") {
+        auto st = ResponseCache::shared().stats();
+        out_ << "Response cache: " << st.hits << " hits, " << st.misses << " misses, "
+             << st.evictions << " evictions, " << st.size << " entries\n";
+        return;
+    }
+
+    if (input == "session stats") {
+        auto st = dm_.sessions().stats();
+        out_ << "Sessions: " << st.hot << " in memory (~" << st.hotBytes << " bytes), " << st.cold
+             << " evicted to disk, " << st.evictions << " evictions, " << st.faults << " faults\n";
+        return;
+    }
+
+    if (input == "log stats") {
+        auto st = EventLog::shared().stats();
+        out_ << "Event log: " << st.recorded << " events, " << st.dropped << " dropped, "
+             << st.bytesWritten << " bytes written, " << st.rotations << " rotations\n";
+        return;
+    }
+
+    if (input == "content stats") {
+        auto st = ContentPool::shared().stats();
+        out_ << "Topic texts: " << st.texts << " in memory (" << st.bytes << " bytes), " << st.shared
+             << " loads shared an identical copy, saving " << st.bytesSaved << " bytes\n";
+        return;
+    }
+
+    // Move through the topics discussed so far
+    if (navigate(input)) {
+        turn_.branch = "context";
+        turn_.topic = topicName(context_.current());
+        return;
+    }
+
+    // Continue a streamed detail reply
+    if (stream_ && (input == "more" || input == "next" || input == "continue")) {
+        turn_.branch = "more";
+        turn_.topic = streamTopic_;
+        streamChunk();
+        return;
+    }
+
+    // Step through one of the algorithms: "show quicksort on 5 3 8 1", then "next"
+    std::string traceArg = input.rfind("next ", 0) == 0 ? input.substr(5) : "";
+    bool traceCommand = input == "next" || input == "more" || traceArg == "all" ||
+                        (!traceArg.empty() && traceArg.find_first_not_of("0123456789") == std::string::npos);
+    if (trace_ && traceCommand) {
+        turn_.branch = "algorithm";
+        const std::string &arg = traceArg;
+        if (arg == "all") {
+            // Run silently to the end, within reason: an O(n^2) sort of 10^6 numbers never would
+            traceHasNext_ = !trace_->finish(kTraceRunLimit) && trace_->next(traceNext_);
+            if (traceHasNext_) {
+                out_ << "Still running after " << trace_->steps() << " steps (" << trace_->summary()
+                     << "). Type 'next' to keep stepping.\n";
+                return;
+            }
+            stepTrace(0);
+            return;
+        }
+        uint64_t steps = kTraceBatch;
+        if (!arg.empty()) {
+            steps = std::min<uint64_t>(std::max(1ULL, std::strtoull(arg.c_str(), nullptr, 10)), kTraceMaxBatch);
+        }
+        stepTrace(steps);
+        return;
+    }
+    if (showAlgorithm(input)) return;
+
+    if (input == "benchmark results" || (input == "results" && benchmark_.valid())) {
+        turn_.branch = "benchmark";
+        if (benchmark_.valid()) deliverBenchmark(true);
+        else out_ << "No benchmark is running. Try: benchmark linear search vs binary search\n";
+        return;
+    }
+    if (input == "benchmark" || input.rfind("benchmark ", 0) == 0) {
+        turn_.branch = "benchmark";
+        startBenchmark(input);
+        return;
+    }
+
+    // Check for progress display request
+    if (containsWords(input, "progress")) {
+        turn_.branch = "progress";
+        showProgress();
+        return;
+    }
+
+    // Repeated questions are answered from the response cache. Replies that named their
+    // topic explicitly are keyed without context; follow-ups are keyed by the context topic.
+    std::string explicitKey = ResponseCache::makeKey(input, "", dm_.course());
+    std::string contextKey = ResponseCache::makeKey(input, getContextTopic(), dm_.course());
+    bool usedContext = false;
+    ResponseCache::Entry cached;
+    if (ResponseCache::shared().get(explicitKey, contextKey, corpusVersion_, cached)) {
+        turn_.intent = cached.intent;
+        turn_.topic = cached.topic;
+        turn_.branch = "cache";
+        if (cached.topic != "unknown") pushTopic(cached.topic);
+        for (auto &l : cached.lines) typePrint(l.text, l.msDelay);
+        if (kHandlers[(size_t)intentFromName(cached.intent)].suggestNext && cached.topic != "unknown") {
+            auto rec = recommendNext(cached.topic);
+            if (!rec.topic.empty()) typePrint("When you're ready, a good next topic is " + rec.topic + ".");
+        }
+        return;
+    }
+
+    auto parsed = parseIntentAndTopic(input, topics(), &dm_.intents());
+    Request req{input, parsed.first, parsed.second, "", "", false, {}};
+
+    // If multiple topics were detected (joined with '|'), pick the most specific one
+    // (highest registry rank, e.g. avl_tree > bst > binary_tree; ties go to the first mentioned)
+    auto chooseBestTopic = [&](const std::string &topicStr) {
+        if (topicStr.find('|') == std::string::npos) return topicStr;
+        std::istringstream pss(topicStr);
+        std::string seg, best;
+        while (std::getline(pss, seg, '|')) {
+            if (!seg.empty() && (best.empty() || topics().rank(seg) > topics().rank(best))) best = seg;
+        }
+        return best.empty() ? std::string("unknown") : best;
+    };
+
+    // pick best topic now; a comparison keeps both topics
+    if (req.topic != "unknown" && req.intent != Intent::Difference) req.topic = chooseBestTopic(req.topic);
+
+    // No topic named: a follow-up ("explain it more", "quiz me on that") is about the current
+    // topic, as long as it is recent. One from long ago is confirmed instead of assumed.
+    // Phrasings like "see you" or "how am i doing" are not follow-ups.
+    if (req.topic == "unknown" && kHandlers[(size_t)req.intent].usesContext) {
+        if (context_.current() >= 0 && context_.resolve() < 0) {
+            turn_.intent = intentName(req.intent);
+            turn_.branch = "context";
+            typePrint("Which topic do you mean? We last talked about " + topicName(context_.current()) +
+                      " a while ago; name it again (e.g. 'explain " + topicName(context_.current()) + "').");
+            return;
+        }
+        if (context_.resolve() >= 0) {
+            req.topic = topicName(context_.resolve());
+            usedContext = true;
+            // For ambiguous requests like "explain in detail", use context
+            if (req.intent == Intent::Unknown) req.intent = Intent::Detail;
+        }
+    }
+
+    const IntentHandler &handler = kHandlers[(size_t)req.intent];
+    static_assert(handlersInOrder(), "kHandlers must list every intent in enum order");
+    turn_.intent = intentName(req.intent);
+    turn_.topic = req.topic;  // after falling back to the context topic
+    turn_.branch = intentName(req.intent);  // the handler may override it (faq, help, fallback)
+    if (req.topic == "unknown" && handler.askTopic) {
+        typePrint(handler.askTopic);
+        return;
+    }
+
+    // The topic becomes current
+    req.mainTopic = req.topic.substr(0, req.topic.find('|'));
+    if (req.topic != "unknown") pushTopic(req.mainTopic);
+
+    if (handler.section && req.topic != "unknown") {
+        req.section = *handler.section ? dm_.loadTopicSection(req.mainTopic, handler.section)
+                                       : dm_.loadTopicContent(req.mainTopic);
+        if (req.section.empty() && *handler.section) {
+            req.fellBack = true;
+            if (handler.fallback) req.section = dm_.loadTopicSection(req.mainTopic, handler.fallback);
+            if (req.section.empty()) req.section = dm_.loadTopicContent(req.mainTopic);
+        }
+        if (!dm_.topicText(req.mainTopic)) req.cacheable = false;  // section is the missing-file placeholder
+    }
+
+    (this->*handler.run)(req);
+
+    // Deterministic replies are printed and memoized, unless they only stand in for missing
+    // content; the suggestion depends on the user's progress, so it is never cached
+    if (!req.reply.empty()) {
+        if (req.cacheable) {
+            ResponseCache::shared().put(usedContext ? contextKey : explicitKey, corpusVersion_,
+                                        {intentName(req.intent), getContextTopic(), req.reply});
+        }
+        for (auto &l : req.reply) typePrint(l.text, l.msDelay);
+    }
+    if (handler.suggestNext && req.topic != "unknown") {
+        auto rec = recommendNext(req.mainTopic);
+        if (!rec.topic.empty()) typePrint("When you're ready, a good next topic is " + rec.topic + ".");
+    }
+}
+
+void ChatEngine::handleLearn(Request &req) {
+    // Show only a concise definition (first paragraph)
+    std::istringstream ss(req.section);
+    std::string line, out;
+    while (std::getline(ss, line)) {
+        if (!line.empty()) { out = line; break; }
+    }
+    if (out.empty()) out = req.section;
+    req.say(out, 1);
+    req.say("Do you want more detail, pseudocode, example, or a quiz?");
+}
+
+void ChatEngine::handleDetail(Request &req) {
+    // The complete topic file, a chunk at a time; "more" continues
+    ContentPool::Text text = dm_.topicText(req.mainTopic);
+    if (!text || text->empty()) {
+        req.say("[No content available for this topic yet.]", 1);
+        req.cacheable = false;
+        return;
+    }
+    // One paged reply at a time: "more" and "next" now belong to this one
+    trace_.reset();
+    traceHasNext_ = false;
+    stream_ = std::move(text);
+    streamTopic_ = req.mainTopic;
+    streamPos_ = 0;
+    streamChunk();
+}
+
+void ChatEngine::handleQuiz(Request &req) {
+    quiz_.runQuiz(req.mainTopic);
+}
+
+void ChatEngine::handleRecommend(Request &req) {
+    auto rec = recommendNext(req.topic);
+    if (rec.topic.empty()) {
+        typePrint("You've covered every topic I know. Try a quiz on a hard difficulty!");
+    } else {
+        typePrint("I suggest studying " + rec.topic + " next: " + rec.reason + ".");
+        typePrint("Say 'teach me " + rec.topic + "' to begin.");
+    }
+}
+
+void ChatEngine::handleProgress(Request &) {
+    showProgress();
+}
+
+void ChatEngine::handleExit(Request &req) {
+    // A sentence that names a topic is about the topic, not a goodbye
+    if (req.topic != "unknown") return handleOther(req);
+    endSession();
+}
+
+void ChatEngine::handleSection(Request &req) {
+    const std::string &input = req.input;
+    const std::string &mainTopic = req.mainTopic;
+    const std::string &section = req.section;
+    if (req.fellBack) {
+        req.say("I couldn't find a specific section. Here's a summary:");
+        req.say(section, 1);
+        req.cacheable = false;
+    } else {
+        // If user asked for specific pseudocode (e.g., preorder/inorder), try to extract only that part
+        if (req.intent == Intent::Pseudocode) {
+            std::vector<std::string> subkeys = {"preorder", "inorder", "postorder", "search", "insert", "delete", "traversal"};
+            std::string foundSub;
+            for (auto &k : subkeys) if (input.find(k) != std::string::npos) { foundSub = k; break; }
+
+            if (!foundSub.empty()) {
+                // Look through the full topic content for labeled pseudocode blocks and return
+                // the single block whose heading or body contains the requested subkey.
+                std::string full = dm_.loadTopicContent(mainTopic);
+                std::istringstream css(full);
+                std::string line;
+                std::string curHeading;
+                std::string curBody;
+                std::vector<std::pair<std::string,std::string>> blocks;
+                while (std::getline(css, line)) {
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    std::string low = lower(line);
+                    if (low.find("pseudocode:") == 0) {
+                        if (!curHeading.empty()) {
+                            blocks.push_back({curHeading, curBody});
+                            curBody.clear();
+                        }
+                        // heading text after label
+                        size_t col = line.find(':');
+                        curHeading = (col==std::string::npos) ? line : line.substr(col+1);
+                        // trim
+                        size_t st = curHeading.find_first_not_of(" \t");
+                        if (st!=std::string::npos) curHeading = curHeading.substr(st);
+                    } else if (!curHeading.empty()) {
+                        if (line.empty()) {
+                            // end of this pseudocode block
+                            blocks.push_back({curHeading, curBody});
+                            curHeading.clear(); curBody.clear();
+                        } else {
+                            if (!curBody.empty()) curBody += "\n";
+                            curBody += line;
+                        }
+                    }
+                }
+                if (!curHeading.empty()) blocks.push_back({curHeading, curBody});
+
+                bool printed = false;
+                for (auto &b : blocks) {
+                    std::string lowh = lower(b.first);
+                    std::string lowb = lower(b.second);
+                    if (lowh.find(foundSub) != std::string::npos || lowb.find(foundSub) != std::string::npos) {
+                        std::string out = b.first + "\n" + b.second;
+                        size_t st = out.find_first_not_of("\n \t");
+                        if (st!=std::string::npos) out = out.substr(st);
+                        req.say(out, 1);
+                        printed = true;
+                        break;
+                    }
+                }
+                if (!printed) {
+                    // fallback to the original section if no specific block found
+                    req.say(section, 1);
+                }
+            } else {
+                req.say(section, 1);
+            }
+        } else {
+            req.say(section, 1);
+        }
+    }
+}
+
+void ChatEngine::handleDifference(Request &req) {
+    const std::string &input = req.input;
+    std::string t1 = req.topic, t2;
+    size_t sep = t1.find('|');
+    if (sep != std::string::npos) {
+        t2 = t1.substr(sep+1);
+        t1 = t1.substr(0, sep);
+        t2 = t2.substr(0, t2.find('|'));
+    }
+    if (t2.empty()) {
+        // Fallback: try splitting the original input around ' and ' or ' vs ' to detect two topics
+        size_t andPos = input.find(" and ");
+        size_t vsPos = input.find(" vs ");
+        size_t splitPos = std::string::npos;
+        if (andPos != std::string::npos) splitPos = andPos;
+        else if (vsPos != std::string::npos) splitPos = vsPos;
+
+        if (splitPos != std::string::npos) {
+            std::string left = input.substr(0, splitPos);
+            std::string right = input.substr(splitPos + ((andPos!=std::string::npos) ? 5 : 4));
+            auto lpair = parseIntentAndTopic(left, topics());
+            auto rpair = parseIntentAndTopic(right, topics());
+            if (lpair.second != "unknown" && rpair.second != "unknown") {
+                t1 = lpair.second;
+                t2 = rpair.second;
+            }
+        }
+
+        if (t2.empty()) {
+            req.say("Please mention two topics to compare (e.g., 'array and linked list').");
+            req.cacheable = false;
+            return;
+        }
+    }
+
+    std::string def1 = dm_.loadTopicSection(t1, "definition");
+    std::string def2 = dm_.loadTopicSection(t2, "definition");
+    if (def1.empty()) def1 = dm_.loadTopicContent(t1);
+    if (def2.empty()) def2 = dm_.loadTopicContent(t2);
+    if (!dm_.topicText(t1) || !dm_.topicText(t2)) req.cacheable = false;  // placeholder for a missing file
+
+    auto firstNonEmpty = [](const std::string &s){
+        std::istringstream ss(s); std::string l; while (std::getline(ss,l)) if (!l.empty()) return l; return std::string(); };
+    std::string c1 = firstNonEmpty(def1);
+    std::string c2 = firstNonEmpty(def2);
+
+    req.say(t1 + ": " + (c1.empty() ? "(no short definition)" : c1));
+    req.say(t2 + ": " + (c2.empty() ? "(no short definition)" : c2));
+    req.say("Short difference:");
+    
+    std::string note = topics().difference(t1, t2);
+    if (!note.empty()) {
+        req.say(note);
+    } else {
+        req.say("(If you want a detailed comparison, ask for more details of both topics one by one,as i dont have one liner difference for it.)");
+    }
+}
+
+void ChatEngine::handleOther(Request &req) {
+    if (req.topic == "unknown") {
+        turn_.branch = "help";
+        typePrint("Hmm... I didn't quite understand. Try something like:");
+        typePrint("  teach me bst");
+        typePrint("  quiz me on queues");
+        typePrint("  give example of stack");
+        typePrint("  difference between array and linked list");
+        typePrint("  show quicksort on 5 3 8 1");
+        typePrint("  back (to the previous topic)");
+        return;
+    }
+
+    // Immediately attempt FAQ-first matching for the topic
+    {
+        const std::string &input = req.input;
+        const std::string &mainTopic = req.mainTopic;
+        std::string faqSection = dm_.loadTopicSection(mainTopic, "FAQ");
+        if (!faqSection.empty()) {
+            std::string normalizedInput = normalizeFAQ(input);
+
+            std::istringstream ss(faqSection);
+            std::string line;
+            std::string curQ, curA;
+            std::string bestAnswer;
+            int bestScore = 0;
+
+            while (std::getline(ss, line)) {
+                if (line.rfind("Q:", 0) == 0) {
+                    curQ = line.substr(2);
+                } else if (line.rfind("A:", 0) == 0) {
+                    curA = line.substr(2);
+                    if (!curQ.empty()) {
+                        std::string normalizedQ = normalizeFAQ(curQ);
+                        int lcs = longestCommonSubstring(normalizedInput, normalizedQ);
+
+                        // If input or question contains the other, treat as strong match
+                        if (!normalizedQ.empty() && (normalizedQ.find(normalizedInput) != std::string::npos || normalizedInput.find(normalizedQ) != std::string::npos)) {
+                            lcs = std::max((int)normalizedInput.size(), (int)normalizedQ.size());
+                        }
+
+                        // If at least half of either string matches, consider it good
+                        int threshold = std::max(1, std::min((int)normalizedQ.size()/2, (int)normalizedInput.size()/2));
+                        if (lcs >= threshold && lcs > bestScore) {
+                            bestScore = lcs;
+                            bestAnswer = curA;
+                        }
+                    }
+                    curQ.clear(); curA.clear();
+                }
+            }
+
+            turn_.faqScore = (float)bestScore;
+            if (bestScore > 0 && !bestAnswer.empty()) {
+                turn_.branch = "faq";
+                req.say(bestAnswer, 1);
+                return;
+            }
+        }
+    }
+    
+
+    turn_.branch = "fallback";
+    typePrint("Sorry, I couldn't handle that request yet. Try 'explain <topic>' or 'quiz <topic>'.");
+}
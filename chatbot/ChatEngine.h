@@ -1,21 +1,122 @@
-#pragma once
-#include "DataManager.h"
-#include "QuizEngine.h"
-#include <string>
-#include <stack>
-#include <vector>
-
-class ChatEngine {
-public:
-    ChatEngine(DataManager &dm);
-    void start();
-private:
-    DataManager &dm_;
-    QuizEngine quiz_;
-    std::stack<std::string> topicStack_;  // Store context of discussed topics
-    std::vector<std::string> sessionTopics_;  // Track all topics in session
-    
-    void typePrint(const std::string &s, int msDelay = 4);
-    std::string getContextTopic();  // Get current topic from stack or return unknown
-    void saveSessionProgress();  // Save session data to user.txt
+#pragma once
+#include "Algorithms.h"
+#include "ComplexityLab.h"
+#include "ConversationContext.h"
+#include "DataManager.h"
+#include "EventLog.h"
+#include "NLP.h"
+#include "QuizEngine.h"
+#include "ResponseCache.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ChatEngine {
+public:
+    ChatEngine(DataManager &dm, const std::string &sessionId = "local", std::ostream &out = std::cout);
+    ~ChatEngine();  // stops a benchmark that is still running
+    void start();  // console loop: reads std::cin and feeds handleMessage()
+
+    // Message-driven interface, so one thread can serve many conversations.
+    // Prompts that used to block on std::getline now wait for the next message.
+    void greet();  // opening lines, plus the welcome-back/resume prompt for a restored session
+    bool handleMessage(const std::string &message);  // false once the conversation has ended
+    bool awaitingReply() const { return (bool)pending_ || quiz_.waiting(); }  // mid-prompt or mid-quiz
+    void setTypingEffect(bool on) { typing_ = on; }
+private:
+    DataManager &dm_;
+    std::ostream &out_;
+    QuizEngine quiz_;
+    ConversationContext context_;  // Topics discussed: current one, back/forward history, visited set
+    std::shared_ptr<const TopicRegistry> topics_;  // Registry context_'s ids refer to, see syncTopics()
+    uint64_t corpusVersion_ = 0;  // Corpus version when this turn began: what its replies are cached under
+    std::string sessionId_;  // Key of this conversation in the session snapshot store
+    std::string username_;  // Last username the user gave us (progress / save prompts)
+    std::function<void(const std::string &)> pending_;  // Continuation waiting for the next message
+    bool typing_ = true;
+    bool finished_ = false;
+    EventLog::Event turn_;  // What the current message was classified as; logged when it is done
+    int64_t typingUs_ = 0;  // Typing-effect time in the current turn, left out of its latency
+    std::unique_ptr<AlgorithmTrace> trace_;  // Algorithm being stepped through ("show quicksort on 5 3 8 1")
+    TraceStep traceNext_;  // Its next step, produced but not printed yet
+    bool traceHasNext_ = false;
+    std::string traceSnapshot_;  // Its data as last printed
+    static constexpr uint64_t kTraceBatch = 10;     // steps printed per "next"
+    static constexpr uint64_t kTraceMaxBatch = 500;  // most steps one "next <n>" prints
+    static constexpr uint64_t kTraceRunLimit = 100000000;  // most steps "next all" runs (about a second)
+    std::future<std::string> benchmark_;  // Report of the benchmark running on a worker thread
+    std::atomic<bool> benchmarkCancel_{false};
+    std::atomic<size_t> benchmarkMeasured_{0};  // (algorithm, size) timings done so far
+    size_t benchmarkTotal_ = 0;
+    static constexpr std::chrono::milliseconds kBenchmarkBudget{5000};
+    ContentPool::Text stream_;  // Topic text a detail reply is being streamed from, shared with the pool
+    std::string streamTopic_;
+    size_t streamPos_ = 0;  // where "more" continues
+    static constexpr size_t kStreamChunk = 1500;  // bytes per chunk, ending at a line break where there is one
+    std::chrono::steady_clock::time_point turnStarted_;
+
+    // A chat turn once its intent and topic are known: what an intent handler works from
+    struct Request {
+        const std::string &input;
+        Intent intent;
+        std::string topic;      // one topic, two joined with '|' for a comparison, or "unknown"
+        std::string mainTopic;  // the first of them
+        std::string section;    // the handler's section of mainTopic, loaded before it runs
+        bool fellBack = false;  // section is a fallback: the handler's own is missing from the topic file
+        std::vector<ResponseCache::Line> reply;  // deterministic lines, printed and cached after the handler
+        bool cacheable = true;  // false for placeholder, fallback and error replies: printed, never cached
+        void say(const std::string &text, int msDelay = 4) { reply.push_back({text, msDelay}); }
+    };
+    // What each intent needs before its handler runs; kHandlers has one per Intent, in enum order
+    struct IntentHandler {
+        Intent intent;
+        const char *section;   // topic section it reads: "" for the whole file, nullptr for none
+        const char *fallback;  // read when that section is missing (then the whole file); nullptr for none
+        const char *askTopic;  // reply when no topic is known; nullptr if the handler does without one
+        bool usesContext;      // a turn that names no topic is about the current one
+        bool suggestNext;      // the reply ends with a suggested next topic (never cached)
+        void (ChatEngine::*run)(Request &);
+    };
+    static const IntentHandler kHandlers[(size_t)Intent::Count];
+    static constexpr bool handlersInOrder();
+    
+    void awaitReply(const std::string &prompt, std::function<void(const std::string &)> next);
+    void handleTurn(const std::string &input);  // one normal chat turn (input as ResponseCache::normalizeInput)
+    void endSession();    // offer to save, say goodbye and drop the session snapshot
+    void showProgress();  // ask for a username and print their quiz history
+    bool showAlgorithm(const std::string &input);  // "show <algorithm> on <input>": start a trace; false if not one
+    void stepTrace(uint64_t steps);  // print the next steps of trace_, dropping it when the algorithm ends
+    void startBenchmark(const std::string &input);  // "benchmark <algorithm> [vs <algorithm>...] [sizes]"
+    void deliverBenchmark(bool asked);  // print the report once it is ready; if asked, say how far it got
+    void typePrint(const std::string &s, int msDelay = 4);
+    void firstByte();  // the reply to this turn starts now (time to first byte, for the event log)
+    void streamChunk();  // print the next chunk of stream_, dropping it after the last one
+    void handleLearn(Request &req);       // first paragraph of the definition
+    void handleDetail(Request &req);      // the whole topic file
+    void handleSection(Request &req);     // example or pseudocode
+    void handleQuiz(Request &req);
+    void handleDifference(Request &req);
+    void handleRecommend(Request &req);
+    void handleProgress(Request &req);
+    void handleExit(Request &req);
+    void handleOther(Request &req);       // FAQ match on the topic, else help
+    std::string getContextTopic();  // The topic a follow-up like "explain it" means, or unknown
+    void pushTopic(const std::string &topic);  // Make topic current and record it for the session
+    std::string topicName(int id) const { return id < 0 || !topics_ ? "unknown" : topics_->topic(id).key; }
+    const TopicRegistry &topics() {
+        if (!topics_) syncTopics();
+        return *topics_;
+    }
+    void syncTopics();  // Move to the course's current registry, carrying context_ over to its ids
+    std::vector<std::string> sessionTopics() const;  // every topic of the session, first visit first
+    bool navigate(const std::string &input);  // "back", "forward", "history"; false if not one
+    void saveSessionProgress(std::function<void()> done);  // Save session data to user.txt, then done()
+    void checkpointSession();  // Snapshot topic stack, session topics and any in-flight quiz
+    bool restoreSession();     // Reload the snapshot left by a previous run; true if found
+    TopicRecommender::Recommendation recommendNext(const std::string &current);  // Next topic from prerequisite graph
 };
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "ChatServer.h"
+#include <iostream>
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static const size_t kMaxLine = 64 * 1024;  // drop clients that never send a newline
+
+ChatServer::ChatServer(CourseCatalog &courses, int port)
+    : courses_(courses), port_(port), idPrefix_(SessionStore::uniqueId("tcp") + "-") {}
+
+#ifdef __linux__
+
+ChatServer::~ChatServer() {
+    for (auto &kv : conns_) ::close(kv.first);
+    if (listenFd_ >= 0) ::close(listenFd_);
+    if (epollFd_ >= 0) ::close(epollFd_);
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool ChatServer::listen() {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) return false;
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port_);
+    if (bind(listenFd_, (sockaddr *)&addr, sizeof(addr)) < 0) return false;
+    if (::listen(listenFd_, SOMAXCONN) < 0) return false;
+    if (!setNonBlocking(listenFd_)) return false;
+
+    epollFd_ = epoll_create1(0);
+    if (epollFd_ < 0) return false;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd_;
+    return epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev) == 0;
+}
+
+int ChatServer::run() {
+    if (!listen()) {
+        std::cout << "Unable to listen on port " << port_ << "\n";
+        return 1;
+    }
+    std::cout << "Serving chat on port " << port_ << "\n";
+
+    epoll_event events[256];
+    while (true) {
+        int n = epoll_wait(epollFd_, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cout << "epoll_wait failed\n";
+            return 1;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                acceptAll();
+                continue;
+            }
+            auto it = conns_.find(fd);
+            if (it == conns_.end()) continue;
+            Connection &c = *it->second;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                closeConnection(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) flush(c);
+            if (conns_.count(fd) && (events[i].events & EPOLLIN)) onReadable(c);
+        }
+    }
+}
+
+void ChatServer::acceptAll() {
+    while (true) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) return;  // EAGAIN: accepted everything pending
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            continue;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        conn->outBuf = "Connected. Send 'course <name>' to pick a course, 'session <name>' to resume a saved "
+                       "conversation, or just start chatting.\n";
+        Connection &c = *conn;
+        conns_[fd] = std::move(conn);
+        flush(c);
+    }
+}
+
+void ChatServer::onReadable(Connection &c) {
+    int fd = c.fd;
+    char buf[4096];
+    while (true) {
+        ssize_t got = recv(fd, buf, sizeof(buf), 0);
+        if (got == 0) {
+            closeConnection(fd);
+            return;
+        }
+        if (got < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            closeConnection(fd);
+            return;
+        }
+        c.inBuf.append(buf, (size_t)got);
+    }
+
+    size_t start = 0, nl;
+    while (!c.closing && (nl = c.inBuf.find('\n', start)) != std::string::npos) {
+        std::string line = c.inBuf.substr(start, nl - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = nl + 1;
+        onLine(c, line);
+    }
+    c.inBuf.erase(0, start);
+    if (c.inBuf.size() > kMaxLine) {
+        closeConnection(fd);
+        return;
+    }
+    flush(c);
+}
+
+void ChatServer::selectCourse(Connection &c, const std::string &name) {
+    if (DataManager *course = courses_.find(name)) {
+        c.course = course;
+        c.outBuf += "Course '" + name + "' selected.\n";
+        return;
+    }
+    c.outBuf += "Unknown course '" + name + "'. Available: default";
+    for (auto &n : courses_.names()) c.outBuf += ", " + n;
+    c.outBuf += "\n";
+}
+
+void ChatServer::onLine(Connection &c, const std::string &line) {
+    if (!c.chat && line.rfind("course ", 0) == 0) {
+        selectCourse(c, line.substr(7));
+        return;
+    }
+    if (!c.chat) {
+        if (!c.course) c.course = &courses_.defaultCourse();
+        std::string sessionId;
+        bool named = line.rfind("session ", 0) == 0 && SessionStore::validName(line.substr(8));
+        if (named) {
+            sessionId = "user:" + line.substr(8);
+        } else {
+            sessionId = idPrefix_ + std::to_string(++nextId_);
+        }
+        c.namedSession = named;
+        c.sessionId = sessionId;
+        c.chat = std::make_unique<ChatEngine>(*c.course, sessionId, c.out);
+        c.chat->setTypingEffect(false);
+        c.chat->greet();
+        if (!named) c.chat->handleMessage(line);
+    } else if (!c.chat->handleMessage(line)) {
+        c.closing = true;
+    }
+    collectOutput(c);
+}
+
+void ChatServer::collectOutput(Connection &c) {
+    if (!c.closing && !c.chat->awaitingReply()) c.out << "\nYou: ";
+    c.outBuf += c.out.str();
+    c.out.str("");
+}
+
+void ChatServer::flush(Connection &c) {
+    while (!c.outBuf.empty()) {
+        ssize_t sent = send(c.fd, c.outBuf.data(), c.outBuf.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(c.fd);
+            return;
+        }
+        c.outBuf.erase(0, (size_t)sent);
+    }
+
+    if (c.outBuf.empty() && c.closing) {
+        closeConnection(c.fd);
+        return;
+    }
+    // Only ask for writability while there is something left to send
+    epoll_event ev{};
+    ev.events = EPOLLIN | (c.outBuf.empty() ? 0u : (uint32_t)EPOLLOUT);
+    ev.data.fd = c.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void ChatServer::closeConnection(int fd) {
+    auto it = conns_.find(fd);
+    if (it == conns_.end()) return;
+    Connection &c = *it->second;
+    // An unnamed conversation cannot be resumed by anyone, so don't keep its snapshot
+    if (c.chat && !c.namedSession && !c.closing) {
+        c.course->sessions().remove(c.sessionId);
+    }
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    conns_.erase(it);
+}
+
+#else
+
+ChatServer::~ChatServer() {}
+
+int ChatServer::run() {
+    std::cout << "Serving over TCP is only supported on Linux.\n";
+    return 1;
+}
+
+#endif
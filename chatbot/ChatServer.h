@@ -0,0 +1,55 @@
+#pragma once
+#include "ChatEngine.h"
+#include "CourseCatalog.h"
+#include "DataManager.h"
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// Line-based TCP front end: one thread and one epoll loop serve every connection.
+// Each connection owns a ChatEngine; a message is a line, and a conversation that is
+// mid-prompt or mid-quiz simply waits for its next line instead of holding a thread.
+// A client may send "session <name>" as its first line to resume a saved conversation,
+// preceded by "course <name>" to talk about a course other than the default one.
+// Turns run on the loop thread, and a few still touch the disk there: faulting in an evicted
+// session, appending quiz and study records (ProgressStore, under its file lock), picking up
+// other processes' records (ProgressStore::refresh) and checking topic files for edits
+// (DataManager::refreshCorpus). Session checkpoints and the event log are written by their own threads.
+// Linux only; elsewhere run() reports that serving is unsupported.
+class ChatServer {
+public:
+    ChatServer(CourseCatalog &courses, int port);
+    ~ChatServer();
+    int run();  // returns the process exit code
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string inBuf;    // bytes received but not yet a full line
+        std::string outBuf;   // bytes the socket has not accepted yet
+        std::ostringstream out;  // conversation output, moved to outBuf after each message
+        DataManager *course = nullptr;     // chosen before the conversation starts; default if unset
+        std::unique_ptr<ChatEngine> chat;  // created by the first line that is not "course <name>"
+        std::string sessionId;
+        bool namedSession = false;  // keep the snapshot on disconnect so it can be resumed
+        bool closing = false;       // conversation ended; close once outBuf drains
+    };
+
+    CourseCatalog &courses_;
+    int port_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    std::string idPrefix_;  // SessionStore::uniqueId of this server, for unnamed sessions
+    unsigned long long nextId_ = 0;
+    std::unordered_map<int, std::unique_ptr<Connection>> conns_;
+
+    bool listen();
+    void acceptAll();
+    void onReadable(Connection &c);
+    void onLine(Connection &c, const std::string &line);
+    void selectCourse(Connection &c, const std::string &name);
+    void collectOutput(Connection &c);
+    void flush(Connection &c);
+    void closeConnection(int fd);
+};
@@ -0,0 +1,273 @@
+#include "ComplexityLab.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> ComplexityLab::busy_{false};
+
+static const uint64_t kChunk = 1 << 20;  // steps run between two looks at the clock
+static const int kMinRuns = 3;
+static const int kMaxRuns = 25;
+static const double kMinTotalSec = 0.02;  // fast sizes repeat until the clock has this much to measure
+
+bool ComplexityLab::reserve() { return !busy_.exchange(true); }
+
+void ComplexityLab::release() { busy_.store(false); }
+
+std::vector<size_t> ComplexityLab::defaultSizes() {
+    std::vector<size_t> sizes;
+    for (size_t n = 1000; n <= 1024000; n *= 2) sizes.push_back(n);
+    return sizes;
+}
+
+// One run on a fresh input. False if the deadline or a cancel interrupted it.
+static bool timeRun(const Algorithms::Info &algo, size_t n, uint32_t seed, Clock::time_point deadline,
+                    const std::atomic<bool> *cancel, double &sec, double &steps) {
+    auto trace = Algorithms::random(algo, n, seed);
+    auto started = Clock::now();
+    while (!trace->finish(kChunk)) {
+        if (Clock::now() > deadline || (cancel && cancel->load(std::memory_order_relaxed))) return false;
+    }
+    sec = std::chrono::duration<double>(Clock::now() - started).count();
+    steps = (double)trace->steps();
+    if (algo.input == Algorithms::Input::Search) {
+        sec /= Algorithms::kLookups;
+        steps /= Algorithms::kLookups;
+    }
+    return true;
+}
+
+std::vector<ComplexityLab::Series> ComplexityLab::run(const std::vector<const Algorithms::Info *> &algos,
+                                                      const Options &opt) {
+    std::vector<Series> out;
+    auto finalDeadline = Clock::now() + opt.budget;
+    uint32_t seed = opt.seed;
+    for (size_t a = 0; a < algos.size(); ++a) {
+        const Algorithms::Info &algo = *algos[a];
+        Series s;
+        s.algo = &algo;
+        // An equal share of what is left; time an algorithm does not use goes to the next ones
+        auto now = Clock::now();
+        auto deadline = now + (finalDeadline - now) / (Clock::rep)(algos.size() - a);
+        double perRun = algo.input == Algorithms::Input::Search ? (double)Algorithms::kLookups : 1.0;
+
+        size_t i = 0;
+        for (; i < opt.sizes.size(); ++i) {
+            size_t n = opt.sizes[i];
+            if (opt.cancel && opt.cancel->load()) break;
+            // Skip a size that cannot finish: guess its run time from the last one, growing at least linearly
+            if (!s.points.empty()) {
+                const Point &last = s.points.back();
+                double growth = std::pow((double)n / last.n, std::max(1.0, s.points.size() > 1 ? s.exponent : 1.0));
+                double guess = last.sec * perRun * growth * (1 + kMinRuns);
+                if (Clock::now() + std::chrono::duration<double>(guess) > deadline) break;
+            }
+
+            double sec = 0, steps = 0;
+            if (!timeRun(algo, n, seed++, deadline, opt.cancel, sec, steps)) break;  // warmup
+            // A run long enough to swamp any warmup effect counts as a sample
+            std::vector<double> samples;
+            double total = 0;
+            if (sec * perRun > 0.1) {
+                samples.push_back(sec);
+                total += sec * perRun;
+            }
+            bool interrupted = false;
+            while ((int)samples.size() < kMaxRuns && ((int)samples.size() < kMinRuns || total < kMinTotalSec)) {
+                // Not enough time for another run: keep the ones there are
+                if (!samples.empty() && Clock::now() + std::chrono::duration<double>(sec * perRun) > deadline) break;
+                if (!timeRun(algo, n, seed++, deadline, opt.cancel, sec, steps)) {
+                    interrupted = samples.empty();
+                    break;
+                }
+                samples.push_back(sec);
+                total += sec * perRun;
+            }
+            if (interrupted) break;
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            s.points.push_back(Point{n, samples[samples.size() / 2], steps, (int)samples.size()});
+            fit(s);
+            if (opt.measured) opt.measured->fetch_add(1);
+        }
+        s.skipped = opt.sizes.size() - i;
+        if (opt.measured) opt.measured->fetch_add(s.skipped);
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+void ComplexityLab::fit(Series &s) {
+    s.model = "";
+    s.exponent = 0;
+    if (s.points.size() < 2) return;
+
+    // Power law: least-squares slope of log time against log n
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, m = (double)s.points.size();
+    for (auto &p : s.points) {
+        double x = std::log((double)p.n), y = std::log(std::max(p.sec, 1e-12));
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    if (m * sxx - sx * sx > 0) s.exponent = (m * sxy - sx * sy) / (m * sxx - sx * sx);
+
+    // Textbook classes: time = c * f(n) with the best c, judged by the spread of log(time / f(n))
+    struct Model {
+        const char *name;
+        double (*f)(double);
+    };
+    static const Model models[] = {
+        {"1", [](double) { return 1.0; }},
+        {"log n", [](double n) { return std::log2(n); }},
+        {"n", [](double n) { return n; }},
+        {"n log n", [](double n) { return n * std::log2(n); }},
+        {"n^2", [](double n) { return n * n; }},
+        {"n^3", [](double n) { return n * n * n; }},
+    };
+    double best = 0;
+    for (auto &model : models) {
+        double sum = 0, sumSq = 0;
+        for (auto &p : s.points) {
+            double r = std::log(std::max(p.sec, 1e-12)) - std::log(model.f((double)p.n));
+            sum += r;
+            sumSq += r * r;
+        }
+        double spread = sumSq / m - (sum / m) * (sum / m);
+        if (!*s.model || spread < best) {
+            best = spread;
+            s.model = model.name;
+        }
+    }
+}
+
+static std::string formatTime(double sec) {
+    char buf[32];
+    if (sec < 1e-6) std::snprintf(buf, sizeof(buf), "%.0f ns", sec * 1e9);
+    else if (sec < 1e-3) std::snprintf(buf, sizeof(buf), "%.1f us", sec * 1e6);
+    else if (sec < 1) std::snprintf(buf, sizeof(buf), "%.1f ms", sec * 1e3);
+    else std::snprintf(buf, sizeof(buf), "%.2f s", sec);
+    return buf;
+}
+
+static std::string formatSize(size_t n) {
+    char buf[32];
+    if (n >= 1000000) std::snprintf(buf, sizeof(buf), "%.3gM", n / 1e6);
+    else if (n >= 1000) std::snprintf(buf, sizeof(buf), "%.3gk", n / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%zu", n);
+    return buf;
+}
+
+static std::string pad(const std::string &s, size_t width) {
+    return s.size() >= width ? s : std::string(width - s.size(), ' ') + s;
+}
+
+// Every size any series measured, ascending
+static std::vector<size_t> allSizes(const std::vector<ComplexityLab::Series> &series) {
+    std::vector<size_t> sizes;
+    for (auto &s : series)
+        for (auto &p : s.points) sizes.push_back(p.n);
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    return sizes;
+}
+
+std::string ComplexityLab::table(const std::vector<Series> &series) {
+    std::vector<size_t> widths;
+    std::string out = pad("n", 9);
+    bool lookups = false, runs = false;
+    for (auto &s : series) {
+        widths.push_back(std::max<size_t>(12, std::string(s.algo->name).size() + 2));
+        out += pad(s.algo->name, widths.back());
+        (s.algo->input == Algorithms::Input::Search ? lookups : runs) = true;
+    }
+    out += "\n";
+
+    for (size_t n : allSizes(series)) {
+        out += pad(std::to_string(n), 9);
+        for (size_t i = 0; i < series.size(); ++i) {
+            std::string cell = "-";
+            for (auto &p : series[i].points)
+                if (p.n == n) cell = formatTime(p.sec);
+            out += pad(cell, widths[i]);
+        }
+        out += "\n";
+    }
+
+    out += pad("grows as", 9);
+    for (size_t i = 0; i < series.size(); ++i)
+        out += pad(*series[i].model ? series[i].model : "?", widths[i]);
+    out += "\n" + pad("n^k, k =", 9);
+    for (size_t i = 0; i < series.size(); ++i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%.2f", series[i].exponent);
+        out += pad(series[i].points.size() > 1 ? buf : "?", widths[i]);
+    }
+    out += "\n";
+
+    out += "Median of repeated runs after a warmup, time ";
+    out += lookups && runs ? "per run (per lookup for the searches)" : lookups ? "per lookup" : "per run";
+    out += ".";
+    out += "\n";
+    for (auto &s : series) {
+        out += std::string(s.algo->name) + ": the course says " + s.algo->complexity + "; measured ";
+        out += *s.model ? std::string("~ ") + s.model : std::string("too few sizes to tell");
+        if (s.skipped)
+            out += " (" + std::to_string(s.skipped) + " larger size" + (s.skipped > 1 ? "s" : "") +
+                   " skipped: out of time)";
+        out += "\n";
+    }
+    return out;
+}
+
+std::string ComplexityLab::plot(const std::vector<Series> &series, int height) {
+    static const char symbols[] = "*o+x#@%$";
+    std::vector<size_t> sizes = allSizes(series);
+    double lo = 0, hi = 0;
+    bool any = false;
+    for (auto &s : series) {
+        for (auto &p : s.points) {
+            double v = std::log10(std::max(p.sec, 1e-12));
+            lo = any ? std::min(lo, v) : v;
+            hi = any ? std::max(hi, v) : v;
+            any = true;
+        }
+    }
+    if (!any || height < 2) return "";
+    if (hi - lo < 1e-9) hi = lo + 1;
+
+    const size_t colWidth = 6;
+    std::vector<std::string> rows((size_t)height, std::string(sizes.size() * colWidth, ' '));
+    for (size_t k = 0; k < series.size(); ++k) {
+        char sym = symbols[k % (sizeof(symbols) - 1)];
+        for (auto &p : series[k].points) {
+            size_t col = (size_t)(std::lower_bound(sizes.begin(), sizes.end(), p.n) - sizes.begin());
+            int row = (int)std::lround((hi - std::log10(std::max(p.sec, 1e-12))) / (hi - lo) * (height - 1));
+            char &cell = rows[(size_t)row][col * colWidth + colWidth / 2];
+            cell = cell == ' ' || cell == sym ? sym : '&';
+        }
+    }
+
+    std::string out;
+    for (int r = 0; r < height; ++r) {
+        // Label the top, middle and bottom rows with the time they stand for
+        std::string label;
+        if (r == 0 || r == height - 1 || r == height / 2)
+            label = formatTime(std::pow(10.0, hi - (hi - lo) * r / (height - 1)));
+        out += pad(label, 9) + " |" + rows[(size_t)r] + "\n";
+    }
+    out += std::string(10, ' ') + "+" + std::string(sizes.size() * colWidth, '-') + "\n" + std::string(11, ' ');
+    for (size_t n : sizes) {
+        std::string label = formatSize(n);
+        size_t left = (colWidth - std::min(colWidth, label.size()) + 1) / 2;
+        out += std::string(left, ' ') + label + std::string(colWidth - std::min(colWidth, left + label.size()), ' ');
+    }
+    out += "  n\n ";
+    for (size_t k = 0; k < series.size(); ++k)
+        out += std::string(" ") + symbols[k % (sizeof(symbols) - 1)] + " " + series[k].algo->name + " ";
+    out += series.size() > 1 ? " & = several" : "";
+    out += "  (both axes logarithmic, so n^k is a line of slope k)\n";
+    return out;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Algorithms.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Times the algorithm library on random inputs of growing size and works out the growth the
+// times actually show, for 'benchmark <algorithm>' and tools/algobench.
+// Every size gets one warmup run and then repeated runs, each on a fresh input built outside
+// the timing, and reports the median. Searches time Algorithms::kLookups lookups per run and
+// report one lookup. Everything stops at the deadline: a size that would not finish in time is
+// skipped, so a quadratic sort costs its share of the budget and no more.
+class ComplexityLab {
+public:
+    struct Point {
+        size_t n;
+        double sec;    // median time of one run (of one lookup for searches)
+        double steps;  // steps in it
+        int runs;
+    };
+    struct Series {
+        const Algorithms::Info *algo;
+        std::vector<Point> points;
+        size_t skipped = 0;      // sizes left out when the budget ran out
+        const char *model = "";  // best fitting growth: "1", "log n", "n", "n log n", "n^2", "n^3"
+        double exponent = 0;     // k in time ~ n^k, least squares on log n / log time
+    };
+    struct Options {
+        std::vector<size_t> sizes;  // ascending
+        std::chrono::milliseconds budget{5000};  // for all the algorithms together
+        uint32_t seed = 1;
+        const std::atomic<bool> *cancel = nullptr;  // stop as soon as it is set
+        std::atomic<size_t> *measured = nullptr;    // counts (algorithm, size) pairs done or skipped
+    };
+
+    static std::vector<size_t> defaultSizes();  // 1000, 2000, 4000 ... 1024000
+    static std::vector<Series> run(const std::vector<const Algorithms::Info *> &algos, const Options &opt);
+
+    static std::string table(const std::vector<Series> &series);
+    // Time against n, both axes logarithmic so that n^k is a straight line of slope k
+    static std::string plot(const std::vector<Series> &series, int height = 12);
+
+    // One benchmark at a time per process: two at once would time each other
+    static bool reserve();  // false if one is running
+    static void release();
+
+private:
+    static std::atomic<bool> busy_;
+    static void fit(Series &s);
+};
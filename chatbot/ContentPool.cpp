@@ -0,0 +1,51 @@
+#include "ContentPool.h"
+
+// FNV-1a, 64-bit
+uint64_t ContentPool::hash(const std::string &s) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+ContentPool::Text ContentPool::intern(std::string content) {
+    uint64_t h = hash(content);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &bucket = byHash_[h];
+    for (size_t i = 0; i < bucket.size();) {
+        Text existing = bucket[i].lock();
+        if (!existing) {
+            // Freed since it was interned; drop the dead entry
+            bucket[i] = bucket.back();
+            bucket.pop_back();
+            continue;
+        }
+        if (*existing == content) {
+            shared_++;
+            bytesSaved_ += content.size();
+            return existing;
+        }
+        ++i;
+    }
+    Text text = std::make_shared<const std::string>(std::move(content));
+    bucket.push_back(text);
+    return text;
+}
+
+ContentPool::Stats ContentPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats st{0, 0, shared_, bytesSaved_};
+    for (auto &kv : byHash_) {
+        for (auto &w : kv.second) {
+            if (Text t = w.lock()) {
+                st.texts++;
+                st.bytes += t->size();
+            }
+        }
+    }
+    return st;
+}
+
+ContentPool &ContentPool::shared() {
+    static ContentPool pool;
+    return pool;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Read-only topic texts shared by every course in the process. Courses often carry copies
+// of the same topic file; intern() keys texts by a 64-bit content hash (compared in full on
+// a hash match), so identical files are held in memory once however many courses load them.
+// The pool only keeps weak references: a text is freed once no course holds it.
+class ContentPool {
+public:
+    using Text = std::shared_ptr<const std::string>;
+
+    struct Stats {
+        size_t texts;       // distinct texts alive
+        size_t bytes;       // their total size
+        uint64_t shared;    // intern() calls answered with an existing text
+        uint64_t bytesSaved;
+    };
+
+    Text intern(std::string content);
+    Stats stats() const;
+
+    static ContentPool &shared();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const std::string>>> byHash_;
+    uint64_t shared_ = 0;
+    uint64_t bytesSaved_ = 0;
+
+    static uint64_t hash(const std::string &s);
+};
@@ -0,0 +1,72 @@
+#include "ConversationContext.h"
+
+void ConversationContext::visit(int topic) {
+    if (topic < 0) return;
+    markVisited(topic);
+    if (size_ && at(cursor_).topic == topic) {
+        at(cursor_).turn = turn_;
+        return;
+    }
+    // A new topic after going back replaces whatever was ahead
+    size_ = size_ ? cursor_ + 1 : 0;
+    if (size_ == kHistory) {  // full: forget the oldest
+        head_ = (head_ + 1) % kHistory;
+        --size_;
+    }
+    at(size_) = Entry{topic, turn_};
+    cursor_ = size_++;
+}
+
+void ConversationContext::markVisited(int topic) {
+    if (topic < 0 || visited(topic)) return;
+    // Grows once per new topic at most, with the registry's ids
+    if ((size_t)topic / 64 >= visited_.size()) visited_.resize((size_t)topic / 64 + 1, 0);
+    visited_[(size_t)topic / 64] |= (uint64_t)1 << (topic % 64);
+    order_.push_back(topic);
+}
+
+void ConversationContext::clear() {
+    head_ = size_ = cursor_ = 0;
+    for (auto &word : visited_) word = 0;
+    order_.clear();
+}
+
+void ConversationContext::remap(const std::vector<int> &newIds) {
+    auto mapped = [&](int topic) { return topic >= 0 && (size_t)topic < newIds.size() ? newIds[(size_t)topic] : -1; };
+    std::array<Entry, kHistory> kept{};
+    int size = 0, cursor = 0;
+    for (int i = 0; i < size_; ++i) {
+        Entry e = at(i);
+        e.topic = mapped(e.topic);
+        // A dropped topic between two visits of the same one leaves a single visit
+        if (e.topic >= 0 && (size == 0 || kept[(size_t)size - 1].topic != e.topic)) kept[(size_t)size++] = e;
+        if (i == cursor_) cursor = size ? size - 1 : 0;  // the current one, or the last kept before it
+    }
+    ring_ = kept;
+    head_ = 0;
+    size_ = size;
+    cursor_ = cursor;
+
+    std::vector<int> order;
+    order.swap(order_);
+    for (auto &word : visited_) word = 0;
+    for (int topic : order) markVisited(mapped(topic));
+}
+
+int ConversationContext::resolve() const {
+    if (!size_) return -1;
+    const Entry &e = at(cursor_);
+    return turn_ - e.turn <= (uint32_t)kStaleTurns ? e.topic : -1;
+}
+
+bool ConversationContext::back() {
+    if (cursor_ == 0) return false;
+    at(--cursor_).turn = turn_;
+    return true;
+}
+
+bool ConversationContext::forward() {
+    if (cursor_ + 1 >= size_) return false;
+    at(++cursor_).turn = turn_;
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Which topics a conversation has been about, by TopicRegistry id.
+// The history works like a browser's: visiting a topic makes it current and drops anything
+// ahead of it, back()/forward() move through it, and only the newest kHistory entries are kept
+// (a ring buffer, so a long session costs no more than a short one). Every operation is O(1)
+// and nothing allocates per turn; the visited set and the first-visit order only grow when a
+// topic is seen for the first time.
+class ConversationContext {
+public:
+    static const int kHistory = 16;    // the session snapshot keeps 16 as well
+    static const int kStaleTurns = 8;  // a topic not mentioned for this many turns is no longer "it"
+
+    void beginTurn() { ++turn_; }  // once per chat turn; ages the current topic
+
+    // The conversation is (again) about topic; it becomes current
+    void visit(int topic);
+    // Only record topic as visited this session (restoring a snapshot), without making it current
+    void markVisited(int topic);
+    void clear();
+    // Move to a rescanned registry: newIds[old id] is the topic's new id, or -1 if it is gone.
+    // Gone topics leave the history and the visited set; the current one stays current if kept.
+    void remap(const std::vector<int> &newIds);
+
+    int current() const { return size_ ? at(cursor_).topic : -1; }  // -1 if none
+    // The topic a follow-up that names none refers to ("explain it more", "quiz me on that"):
+    // the current topic while it is recent, otherwise -1, and the bot asks instead of guessing
+    int resolve() const;
+
+    bool back();     // make the previous topic current; false at the oldest one
+    bool forward();  // undo a back(); false if there is nothing ahead
+    int previous() const { return cursor_ > 0 ? at(cursor_ - 1).topic : -1; }
+    int next() const { return cursor_ + 1 < size_ ? at(cursor_ + 1).topic : -1; }
+
+    // History, oldest first; position() is the current entry's index
+    int size() const { return size_; }
+    int topicAt(int i) const { return at(i).topic; }
+    int position() const { return cursor_; }
+
+    bool visited(int topic) const {
+        return topic >= 0 && (size_t)topic / 64 < visited_.size() && (visited_[(size_t)topic / 64] >> (topic % 64) & 1);
+    }
+    const std::vector<int> &visitOrder() const { return order_; }  // each topic once, first visit first
+
+private:
+    struct Entry {
+        int topic;
+        uint32_t turn;  // last turn it was current
+    };
+    std::array<Entry, kHistory> ring_{};
+    int head_ = 0;    // ring index of the oldest entry
+    int size_ = 0;
+    int cursor_ = 0;  // current entry, counted from the oldest
+    uint32_t turn_ = 0;
+    std::vector<uint64_t> visited_;  // bitset over topic ids
+    std::vector<int> order_;
+
+    Entry &at(int i) { return ring_[(size_t)((head_ + i) % kHistory)]; }
+    const Entry &at(int i) const { return ring_[(size_t)((head_ + i) % kHistory)]; }
+};
@@ -0,0 +1,37 @@
+#include "CourseCatalog.h"
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+CourseCatalog::CourseCatalog(const fs::path &dataPath, StartupTrace *trace) {
+    courses_[""] = std::make_unique<DataManager>(dataPath, std::string(), trace);
+
+    std::error_code ec;
+    fs::path root = dataPath / "courses";
+    if (!fs::is_directory(root, ec)) return;
+    for (auto &entry : fs::directory_iterator(root, ec)) {
+        if (!fs::is_directory(entry.path() / "topics", ec)) continue;
+        std::string name = entry.path().filename().string();
+        if (name == "default") continue;  // reserved for the data folder itself
+        StartupTrace::Phase phase(trace, "course " + name);
+        courses_[name] = std::make_unique<DataManager>(entry.path(), name);
+    }
+}
+
+DataManager *CourseCatalog::find(const std::string &name) const {
+    auto it = courses_.find(name == "default" ? std::string() : name);
+    return it == courses_.end() ? nullptr : it->second.get();
+}
+
+DataManager &CourseCatalog::defaultCourse() const {
+    return *courses_.at("");
+}
+
+std::vector<std::string> CourseCatalog::names() const {
+    std::vector<std::string> out;
+    for (auto &kv : courses_) {
+        if (!kv.first.empty()) out.push_back(kv.first);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "DataManager.h"
+#include "StartupTrace.h"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every course one process serves. The default course is the data folder itself; each
+// data/courses/<name>/ with a topics/ folder is another course, with its own corpus and its
+// own user store (progress, sessions). Courses share the read-only topic texts (ContentPool)
+// and the response cache, whose keys carry the course name.
+class CourseCatalog {
+public:
+    CourseCatalog(const std::filesystem::path &dataPath, StartupTrace *trace = nullptr);
+    // nullptr for an unknown course. "" and "default" name the default course.
+    DataManager *find(const std::string &name) const;
+    DataManager &defaultCourse() const;
+    std::vector<std::string> names() const;  // sorted, not including the default course
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<DataManager>> courses_;
+};
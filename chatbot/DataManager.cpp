@@ -1,165 +1,369 @@
-#include "DataManager.h"
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <string>
-
-DataManager::DataManager(const std::string &basePath) : basePath_(basePath) {
-    ensureUserFiles();
-}
-
-std::string DataManager::loadTopicContent(const std::string &topic) {
-    std::string path = basePath_ + "\\topics\\" + topic + ".txt";
-    std::ifstream in(path);
-    if (!in) return "[No content available for this topic yet.]";
-    std::ostringstream ss;
-    ss << in.rdbuf();
-    return ss.str();
-}
-
-// Case-insensitive search for a section heading (e.g. "Definition:") and return its body.
-std::string DataManager::loadTopicSection(const std::string &topic, const std::string &section) {
-    std::string content = loadTopicContent(topic);
-    if (content.rfind("[No content available", 0) == 0) return std::string();
-    // Split content into lines and find a heading that matches the requested section (case-insensitive)
-    std::istringstream ss(content);
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(ss, line)) {
-        // trim CR
-        if (!line.empty() && line.back() == '\r') line.pop_back();
-        lines.push_back(line);
-    }
-
-    std::string lowerSection = section;
-    for (auto &c : lowerSection) c = (char)std::tolower((unsigned char)c);
-
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::string lowerLine = lines[i];
-        for (auto &c : lowerLine) c = (char)std::tolower((unsigned char)c);
-
-        // match heading like "Definition:" at the beginning, or exactly the word (case-insensitive)
-        if (lowerLine.find(lowerSection + ":") == 0 || lowerLine == lowerSection) {
-            // collect the paragraph immediately following the heading (until the next blank line)
-            std::string out;
-            size_t j = i + 1;
-            while (j < lines.size()) {
-                if (lines[j].empty()) break; // paragraph ended
-                if (!out.empty()) out += "\n";
-                out += lines[j];
-                ++j;
-            }
-
-            // trim leading/trailing whitespace
-            size_t startTrim = out.find_first_not_of("\n \t");
-            if (startTrim == std::string::npos) return std::string();
-            size_t endTrim = out.find_last_not_of("\n \t");
-            return out.substr(startTrim, endTrim - startTrim + 1);
-        }
-    }
-
-    // Try common alternate heading names (fallback)
-    // Only match these as headings if they are at the beginning of the line (after trimming) or followed by colon
-    std::vector<std::string> alternates = {"definition","introduction","intro","representation","types","overview"};
-    for (auto &alt : alternates) {
-        std::string lowAlt = alt;
-        for (auto &c : lowAlt) c = (char)std::tolower((unsigned char)c);
-        for (size_t i = 0; i < lines.size(); ++i) {
-            std::string lowerLine = lines[i];
-            for (auto &c : lowerLine) c = (char)std::tolower((unsigned char)c);
-            // Only match if it's a heading with colon, or the entire line is just the word
-            if (lowerLine.find(lowAlt + ":") == 0 || lowerLine == lowAlt) {
-                std::string out;
-                size_t j = i + 1;
-                while (j < lines.size()) {
-                    if (lines[j].empty()) break;
-                    if (!out.empty()) out += "\n";
-                    out += lines[j];
-                    ++j;
-                }
-                size_t startTrim = out.find_first_not_of("\n \t");
-                if (startTrim == std::string::npos) return std::string();
-                size_t endTrim = out.find_last_not_of("\n \t");
-                return out.substr(startTrim, endTrim - startTrim + 1);
-            }
-        }
-    }
-
-    return std::string();
-}
-
-void DataManager::ensureUserFiles() {
-    // Ensure user directory exists and initialize progress.txt
-    std::string userDir = basePath_ + "\\user";
-    std::string profilePath = userDir + "\\profile.txt";
-    std::string progressPath = userDir + "\\progress.txt";
-    std::string quizPath = userDir + "\\quiz_progress.txt";
-    std::string topicsPath = userDir + "\\topics_history.txt";
-
-    std::ifstream checkProfile(profilePath);
-    if (!checkProfile) {
-        std::ofstream outProfile(profilePath);
-        outProfile << "username:guest\nquizzes_taken:0\n";
-        outProfile.close();
-    }
-
-    // Migrate legacy progress.txt if present into two separate files:
-    // - quiz_progress.txt : stores one quiz entry per line (username|topic:score/total:difficulty)
-    // - topics_history.txt : stores one session entry per line (username|sessions:topic1,topic2,...)
-    std::ifstream oldProgress(progressPath);
-    if (oldProgress) {
-        std::vector<std::string> quizLines;
-        std::vector<std::string> topicLines;
-        std::string line;
-        while (std::getline(oldProgress, line)) {
-            if (line.empty()) continue;
-            if (line.rfind("#", 0) == 0) continue;
-            size_t pipe = line.find('|');
-            if (pipe == std::string::npos) continue;
-            std::string right = line.substr(pipe + 1);
-            if (right.rfind("sessions:", 0) == 0) {
-                // Keep the whole sessions line as-is
-                topicLines.push_back(line);
-            } else {
-                // quizzes may be comma-separated; split them to one-per-line
-                std::istringstream ss(right);
-                std::string quiz;
-                while (std::getline(ss, quiz, ',')) {
-                    if (quiz.empty()) continue;
-                    std::string outLine = line.substr(0, pipe + 1) + quiz;
-                    quizLines.push_back(outLine);
-                }
-            }
-        }
-        oldProgress.close();
-
-        if (!quizLines.empty()) {
-            std::ofstream outQuiz(quizPath, std::ios::app);
-            for (auto &l : quizLines) outQuiz << l << "\n";
-        }
-        if (!topicLines.empty()) {
-            std::ofstream outTopics(topicsPath, std::ios::app);
-            for (auto &l : topicLines) outTopics << l << "\n";
-        }
-    }
-
-    // Ensure quiz_progress.txt exists
-    std::ifstream checkQuiz(quizPath);
-    if (!checkQuiz) {
-        std::ofstream outQuiz(quizPath);
-        outQuiz << "# Quiz progress file\n# Format: username|topic:score/total:difficulty\n";
-        outQuiz.close();
-    }
-
-    // Ensure topics_history.txt exists
-    std::ifstream checkTopics(topicsPath);
-    if (!checkTopics) {
-        std::ofstream outTopics(topicsPath);
-        outTopics << "# Topics history file\n# Format: username|sessions:topic1,topic2,...\n";
-        outTopics.close();
-    }
-}
-
-std::string DataManager::getBasePath() const {
-    return basePath_;
+#include "DataManager.h"
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+
+DataManager::DataManager(const std::filesystem::path &basePath, const std::string &course, StartupTrace *trace)
+    : basePath_(basePath), course_(course), sessions_((basePath / "user" / "sessions.snap").string()) {
+    {
+        StartupTrace::Phase phase(trace, "user files");
+        ensureUserFiles();
+    }
+
+    // The first message is the first use of the registry, so the scan finishes behind the prompt
+    topicsReady_ = std::async(std::launch::async, [this, trace]() {
+        StartupTrace::Phase phase(trace, "topic registry");
+        size_t count = 0;
+        CorpusStamp stamp;
+        std::shared_ptr<const TopicRegistry> topics = scanTopics(count, stamp);
+        {
+            std::lock_guard<std::mutex> lock(corpusMutex_);
+            topics_ = std::move(topics);
+            scanned_ = stamp;
+        }
+        phase.note(std::to_string(count) + " topics");
+    }).share();
+
+    // Study records may only name topics of this course (anything else is a torn record)
+    analytics_.setKnownTopics([this](const std::string &topic) { return topics()->find(topic) >= 0; });
+    // Not needed for the first prompt: runs behind it, and analytics queries wait for it
+    analytics_.loadInBackground([this, trace]() {
+        {
+            StartupTrace::Phase phase(trace, "legacy migration");
+            migrateLegacyProgress();
+        }
+        StartupTrace::Phase phase(trace, "progress index");
+        progress_.sync();
+    });
+
+    // The corpus files are independent of each other, so they load side by side
+    std::thread intents([this, trace]() {
+        StartupTrace::Phase phase(trace, "intent model");
+        intents_.load((basePath_ / "intent_model.txt").string());
+    });
+    std::thread recommender([this, trace]() {
+        StartupTrace::Phase phase(trace, "prerequisites");
+        recommender_.load((basePath_ / "prerequisites.txt").string());
+    });
+    std::thread sessions([this, trace]() {
+        StartupTrace::Phase phase(trace, "session snapshots");
+        sessions_.restore();
+    });
+    quizzes_ = std::make_shared<QuizBank>();
+    quizzes_->buildInBackground([this, trace, bank = quizzes_.get()]() {
+        std::shared_ptr<const TopicRegistry> topics = this->topics();
+        StartupTrace::Phase phase(trace, "quiz bank");
+        size_t generated = bank->build(*topics, basePath_ / "topics",
+                                       [this](const std::string &topic) { return loadTopicContent(topic); });
+        phase.note(std::to_string(generated) + " generated questions");
+    });
+    intents.join();
+    recommender.join();
+    sessions.join();
+    sessions_.startWriter();
+}
+
+DataManager::~DataManager() {
+    // The background work uses members destroyed before the ones it fills
+    analytics_.waitUntilLoaded();
+    if (rebuild_.valid()) rebuild_.wait();
+    quizzes_->waitUntilBuilt();
+}
+
+std::string DataManager::loadTopicContent(const std::string &topic) {
+    ContentPool::Text text = topicText(topic);
+    return text ? *text : "[No content available for this topic yet.]";
+}
+
+ContentPool::Text DataManager::topicText(const std::string &topic) {
+    {
+        std::lock_guard<std::mutex> lock(contentMutex_);
+        auto it = content_.find(topic);
+        if (it != content_.end()) return it->second.text;
+    }
+    std::filesystem::path path = basePath_ / "topics" / (topic + ".txt");
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);  // before reading: an edit in between shows up later
+    std::ifstream in(path);
+    if (!in) return nullptr;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    // The metadata header (@aliases, @rank) is for the registry, not the reader
+    std::string content = ss.str();
+    ContentPool::Text text = ContentPool::shared().intern(content.substr(TopicRegistry::headerLength(content)));
+    std::lock_guard<std::mutex> lock(contentMutex_);
+    content_.emplace(topic, CachedText{text, mtime});
+    return text;
+}
+
+// Case-insensitive search for a section heading (e.g. "Definition:") and return its body.
+std::string DataManager::loadTopicSection(const std::string &topic, const std::string &section) {
+    ContentPool::Text content = topicText(topic);
+    if (!content) return std::string();
+    // Split content into lines and find a heading that matches the requested section (case-insensitive)
+    std::istringstream ss(*content);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(ss, line)) {
+        // trim CR
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+
+    std::string lowerSection = section;
+    for (auto &c : lowerSection) c = (char)std::tolower((unsigned char)c);
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::string lowerLine = lines[i];
+        for (auto &c : lowerLine) c = (char)std::tolower((unsigned char)c);
+
+        // match heading like "Definition:" at the beginning, or exactly the word (case-insensitive)
+        if (lowerLine.find(lowerSection + ":") == 0 || lowerLine == lowerSection) {
+            // collect the paragraph immediately following the heading (until the next blank line)
+            std::string out;
+            size_t j = i + 1;
+            while (j < lines.size()) {
+                if (lines[j].empty()) break; // paragraph ended
+                if (!out.empty()) out += "\n";
+                out += lines[j];
+                ++j;
+            }
+
+            // trim leading/trailing whitespace
+            size_t startTrim = out.find_first_not_of("\n \t");
+            if (startTrim == std::string::npos) return std::string();
+            size_t endTrim = out.find_last_not_of("\n \t");
+            return out.substr(startTrim, endTrim - startTrim + 1);
+        }
+    }
+
+    // Try common alternate heading names (fallback)
+    // Only match these as headings if they are at the beginning of the line (after trimming) or followed by colon
+    std::vector<std::string> alternates = {"definition","introduction","intro","representation","types","overview"};
+    for (auto &alt : alternates) {
+        std::string lowAlt = alt;
+        for (auto &c : lowAlt) c = (char)std::tolower((unsigned char)c);
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::string lowerLine = lines[i];
+            for (auto &c : lowerLine) c = (char)std::tolower((unsigned char)c);
+            // Only match if it's a heading with colon, or the entire line is just the word
+            if (lowerLine.find(lowAlt + ":") == 0 || lowerLine == lowAlt) {
+                std::string out;
+                size_t j = i + 1;
+                while (j < lines.size()) {
+                    if (lines[j].empty()) break;
+                    if (!out.empty()) out += "\n";
+                    out += lines[j];
+                    ++j;
+                }
+                size_t startTrim = out.find_first_not_of("\n \t");
+                if (startTrim == std::string::npos) return std::string();
+                size_t endTrim = out.find_last_not_of("\n \t");
+                return out.substr(startTrim, endTrim - startTrim + 1);
+            }
+        }
+    }
+
+    return std::string();
+}
+
+void DataManager::ensureUserFiles() {
+    // Ensure the user directory and its files exist (a new course starts without them).
+    // Other processes may share the folder, so existing files are never rewritten.
+    std::error_code ec;
+    std::filesystem::create_directories(userDir(), ec);
+
+    std::filesystem::path profilePath = userDir() / "profile.txt";
+    if (!std::filesystem::exists(profilePath, ec)) {
+        // "x": fails instead of truncating if another process created it meanwhile
+        if (FILE *outProfile = std::fopen(profilePath.string().c_str(), "wx")) {
+            std::fputs("username:guest\nquizzes_taken:0\n", outProfile);
+            std::fclose(outProfile);
+        }
+    }
+
+    // quiz_progress.txt and topics_history.txt
+    if (!progress_.open(userDir())) {
+        std::cout << "Unable to open the progress files in " << userDir().string() << "\n";
+    }
+}
+
+void DataManager::migrateLegacyProgress() {
+    std::filesystem::path progressPath = userDir() / "progress.txt";
+    // Set the old file aside first: the rename succeeds in only one of several processes
+    // starting together, so the records are appended once
+    std::filesystem::path migratedPath = progressPath.string() + ".migrated";
+    std::error_code ec;
+    std::filesystem::rename(progressPath, migratedPath, ec);
+    if (ec) return;
+
+    // Migrate legacy progress.txt if present into two separate files:
+    // - quiz_progress.txt : stores one quiz entry per line (username|topic:score/total:difficulty)
+    // - topics_history.txt : stores one session entry per line (username|sessions:topic1,topic2,...)
+    std::ifstream oldProgress(migratedPath);
+    if (!oldProgress) return;
+    std::vector<std::string> quizLines;
+    std::vector<std::string> topicLines;
+    std::string line;
+    while (std::getline(oldProgress, line)) {
+        if (line.empty()) continue;
+        if (line.rfind("#", 0) == 0) continue;
+        size_t pipe = line.find('|');
+        if (pipe == std::string::npos) continue;
+        std::string right = line.substr(pipe + 1);
+        if (right.rfind("sessions:", 0) == 0) {
+            // Keep the whole sessions line as-is
+            topicLines.push_back(line);
+        } else {
+            // quizzes may be comma-separated; split them to one-per-line
+            std::istringstream ss(right);
+            std::string quiz;
+            while (std::getline(ss, quiz, ',')) {
+                if (quiz.empty()) continue;
+                std::string outLine = line.substr(0, pipe + 1) + quiz;
+                quizLines.push_back(outLine);
+            }
+        }
+    }
+    oldProgress.close();
+
+    progress_.appendQuizLines(quizLines);
+    progress_.appendSessionLines(topicLines);
+}
+
+const std::filesystem::path &DataManager::getBasePath() const {
+    return basePath_;
+}
+
+std::filesystem::path DataManager::userDir() const {
+    return basePath_ / "user";
+}
+
+LearningAnalytics &DataManager::analytics() {
+    return analytics_;
+}
+
+ProgressStore &DataManager::progress() {
+    return progress_;
+}
+
+const TopicRecommender &DataManager::recommender() const {
+    return recommender_;
+}
+
+std::shared_ptr<const TopicRegistry> DataManager::topics() const {
+    topicsReady_.wait();
+    std::lock_guard<std::mutex> lock(corpusMutex_);
+    return topics_;
+}
+
+std::shared_ptr<const QuizBank> DataManager::quizzes() const {
+    std::lock_guard<std::mutex> lock(corpusMutex_);
+    return quizzes_;
+}
+
+const IntentClassifier &DataManager::intents() const {
+    return intents_;
+}
+
+SessionStore &DataManager::sessions() {
+    return sessions_;
+}
+
+uint64_t DataManager::corpusVersion() const {
+    return corpusVersion_.load();
+}
+
+void DataManager::refreshCorpus() {
+    using Clock = std::chrono::steady_clock;
+    int64_t now = Clock::now().time_since_epoch().count();
+    int64_t last = lastCorpusCheck_.load(std::memory_order_relaxed);
+    if (now - last < std::chrono::duration_cast<Clock::duration>(kCorpusCheckInterval).count()) return;
+    if (!lastCorpusCheck_.compare_exchange_strong(last, now)) return;  // another thread is checking
+    if (topicsReady_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;  // still starting
+
+    CorpusStamp scanned;
+    {
+        std::lock_guard<std::mutex> lock(corpusMutex_);
+        scanned = scanned_;
+    }
+    // A topic added, removed or renamed changes the folder's time
+    bool changed = corpusStamp() != scanned;
+    if (!changed) {
+        std::lock_guard<std::mutex> lock(contentMutex_);
+        for (auto &kv : content_) {
+            std::error_code ec;
+            auto mtime = std::filesystem::last_write_time(basePath_ / "topics" / (kv.first + ".txt"), ec);
+            if (ec || mtime != kv.second.mtime) {
+                changed = true;
+                break;
+            }
+        }
+    }
+    if (!changed) return;
+
+    // An edited file may have new aliases as well as new text, so the registry is rescanned on
+    // any change, on the turn that noticed it; it only reads the start of each file, unlike the quiz bank
+    size_t count = 0;
+    CorpusStamp stamp;
+    std::shared_ptr<const TopicRegistry> topics = scanTopics(count, stamp);
+    {
+        std::lock_guard<std::mutex> lock(corpusMutex_);
+        topics_.swap(topics);
+        scanned_ = stamp;
+    }
+    bumpCorpusVersion();
+
+    std::lock_guard<std::mutex> lock(rebuildMutex_);
+    if (rebuilding_) {
+        rebuildAgain_ = true;  // the running one read the old registry
+        return;
+    }
+    rebuilding_ = true;
+    if (rebuild_.valid()) rebuild_.wait();  // the last one, already done
+    rebuild_ = std::async(std::launch::async, [this]() { rebuildQuizzes(); });
+}
+
+void DataManager::rebuildQuizzes() {
+    while (true) {
+        std::shared_ptr<QuizBank> quizzes = std::make_shared<QuizBank>();
+        quizzes->build(*topics(), basePath_ / "topics", [this](const std::string &topic) { return loadTopicContent(topic); });
+        {
+            std::lock_guard<std::mutex> lock(corpusMutex_);
+            quizzes_.swap(quizzes);
+        }  // the old bank goes once the last quiz taken from it lets go, outside the lock
+        std::lock_guard<std::mutex> lock(rebuildMutex_);
+        if (!rebuildAgain_) {
+            rebuilding_ = false;
+            return;
+        }
+        rebuildAgain_ = false;
+    }
+}
+
+DataManager::CorpusStamp DataManager::corpusStamp() const {
+    std::error_code ec;  // a missing folder or file reads as the minimum time, consistently
+    return {std::filesystem::last_write_time(basePath_ / "topics", ec),
+            std::filesystem::last_write_time(basePath_ / "differences.txt", ec)};
+}
+
+std::shared_ptr<const TopicRegistry> DataManager::scanTopics(size_t &count, CorpusStamp &stamp) const {
+    stamp = corpusStamp();
+    std::shared_ptr<TopicRegistry> topics = std::make_shared<TopicRegistry>();
+    count = topics->scan((basePath_ / "topics").string());
+    topics->loadDifferences((basePath_ / "differences.txt").string());
+    return topics;
+}
+
+void DataManager::bumpCorpusVersion() {
+    {
+        std::lock_guard<std::mutex> lock(contentMutex_);
+        content_.clear();
+    }
+    corpusVersion_++;
 }
\ No newline at end of file
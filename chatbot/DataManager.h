@@ -1,15 +1,110 @@
-#pragma once
-#include <string>
-
-class DataManager {
-public:
-    DataManager(const std::string &basePath);
-    std::string loadTopicContent(const std::string &topic);
-    // Load a specific named section from a topic file (case-insensitive), e.g. "definition", "pseudocode", "example", "faq".
-    // Returns empty string if section not found.
-    std::string loadTopicSection(const std::string &topic, const std::string &section);
-    void ensureUserFiles();
-    std::string getBasePath() const;
-private:
-    std::string basePath_; // root path to data folder
+#pragma once
+#include "ContentPool.h"
+#include "IntentClassifier.h"
+#include "LearningAnalytics.h"
+#include "ProgressStore.h"
+#include "QuizBank.h"
+#include "SessionStore.h"
+#include "StartupTrace.h"
+#include "TopicRegistry.h"
+#include "TopicRecommender.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// One course: its corpus (topics/, differences.txt, prerequisites.txt, intent_model.txt)
+// and its user store (user/), all under basePath. See CourseCatalog for several courses.
+class DataManager {
+public:
+    // Corpus files are loaded in parallel. Work the first prompt does not need finishes in the
+    // background: the topic scan (topics() waits for it), and the legacy progress.txt migration
+    // plus the progress index (see LearningAnalytics::loadInBackground).
+    // Phases are timed into `trace` when one is given (--startup-trace).
+    DataManager(const std::filesystem::path &basePath, const std::string &course = std::string(),
+                StartupTrace *trace = nullptr);
+    ~DataManager();
+    // Topic text without its metadata header. Read once, then served from memory; identical
+    // files in different courses share one copy (ContentPool).
+    std::string loadTopicContent(const std::string &topic);
+    // The same text without a copy, for readers that go through it piece by piece (streamed
+    // replies); nullptr if the topic has no file
+    ContentPool::Text topicText(const std::string &topic);
+    // Load a specific named section from a topic file (case-insensitive), e.g. "definition", "pseudocode", "example", "faq".
+    // Returns empty string if section not found.
+    std::string loadTopicSection(const std::string &topic, const std::string &section);
+    void ensureUserFiles();
+    const std::filesystem::path &getBasePath() const;
+    std::filesystem::path userDir() const;  // basePath/user
+    const std::string &course() const { return course_; }  // empty for the default course
+    // Bumped whenever topic content may have changed; cached responses from older versions are dropped,
+    // and topic texts are read again
+    uint64_t corpusVersion() const;
+    void bumpCorpusVersion();
+    // If the topics folder or differences.txt changed since the last scan, or a topic file read
+    // so far was edited or removed: rescan the registry and bump the version, then rebuild the
+    // quiz bank on a background thread, which swaps it in when done (quizzes started before that
+    // come from the old one). Looks at the files at most every kCorpusCheckInterval, so it can be
+    // called on every message.
+    void refreshCorpus();
+    static constexpr std::chrono::milliseconds kCorpusCheckInterval{1000};
+    // Shared learning analytics, loaded from the user files at startup and kept in step with them
+    // by progress()
+    LearningAnalytics &analytics();
+    // Quiz results and study sessions (user/quiz_progress.txt, user/topics_history.txt), safe to
+    // share with other processes
+    ProgressStore &progress();
+    // Prerequisite graph for next-topic suggestions (data/prerequisites.txt)
+    const TopicRecommender &recommender() const;
+    // Topics found in data/topics (aliases, rank) plus data/differences.txt.
+    // Waits for the startup scan if it is still running. A rebuild replaces the registry rather
+    // than changing it, so a caller holding this one can go on using it (ids may differ in the next).
+    std::shared_ptr<const TopicRegistry> topics() const;
+    // Quiz questions of every topic, authored and generated; built behind the first prompt
+    // once the topics are known (queries wait for it). Rebuilt after the registry is rescanned.
+    std::shared_ptr<const QuizBank> quizzes() const;
+    // Intent model (data/intent_model.txt); not loaded() if the file is missing
+    const IntentClassifier &intents() const;
+    // Conversation snapshots (data/user/sessions.snap), restored at startup
+    SessionStore &sessions();
+private:
+    std::filesystem::path basePath_; // root path to data folder
+    std::string course_;
+    // The topics folder and differences.txt modification times, as of a scan
+    using CorpusStamp = std::pair<std::filesystem::file_time_type, std::filesystem::file_time_type>;
+    mutable std::mutex corpusMutex_;  // guards the three below
+    std::shared_ptr<const TopicRegistry> topics_;
+    std::shared_ptr<QuizBank> quizzes_;
+    CorpusStamp scanned_;
+    std::shared_future<void> topicsReady_;  // the startup scan, which sets topics_
+    std::mutex rebuildMutex_;
+    std::future<void> rebuild_;  // a quiz bank rebuild, see refreshCorpus()
+    bool rebuilding_ = false;    // under rebuildMutex_, like the one below
+    bool rebuildAgain_ = false;  // the registry changed again during the rebuild
+    IntentClassifier intents_;
+    LearningAnalytics analytics_;
+    ProgressStore progress_{analytics_};
+    TopicRecommender recommender_;
+    SessionStore sessions_;
+    std::atomic<uint64_t> corpusVersion_{1};
+    std::atomic<int64_t> lastCorpusCheck_{0};  // steady_clock ticks
+    struct CachedText {
+        ContentPool::Text text;
+        std::filesystem::file_time_type mtime;  // of the file it was read from
+    };
+    std::mutex contentMutex_;
+    std::unordered_map<std::string, CachedText> content_;  // topic -> text, filled on first use
+
+    void migrateLegacyProgress();  // split user/progress.txt into the two progress files
+    CorpusStamp corpusStamp() const;
+    // A new registry of the topics folder; stamp is taken before the scan, so an edit made
+    // during it is seen by the next check
+    std::shared_ptr<const TopicRegistry> scanTopics(size_t &count, CorpusStamp &stamp) const;
+    void rebuildQuizzes();  // on the rebuild_ thread
 };
\ No newline at end of file
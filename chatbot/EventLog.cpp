@@ -0,0 +1,237 @@
+#include "EventLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+EventLog::~EventLog() {
+    close();
+}
+
+EventLog &EventLog::shared() {
+    static EventLog instance;
+    return instance;
+}
+
+bool EventLog::open(const std::string &path, uint64_t maxBytes, int keep) {
+    close();
+    path_ = path;
+    maxBytes_ = maxBytes;
+    keep_ = keep;
+#ifdef _WIN32
+    HANDLE h = CreateFileA((path_ + ".lock").c_str(), GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    lockHandle_ = h;
+#else
+    lockFd_ = ::open((path_ + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd_ < 0) return false;
+#endif
+    // Fail now, not in the writer, if the log itself can't be written
+    uint64_t size = 0;
+    std::FILE *f = lockFile() ? openFile(size) : nullptr;
+    if (f) std::fclose(f);
+    unlockFile();
+    if (!f) {
+        closeLock();
+        return false;
+    }
+    stop_ = false;
+    writer_ = std::thread(&EventLog::writerLoop, this);
+    open_.store(true);
+    return true;
+}
+
+void EventLog::close() {
+    if (!open_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    closeLock();
+}
+
+EventLog::Ring *EventLog::localRing() {
+    // One ring per thread for the life of the process
+    thread_local Ring *ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.emplace_back(new Ring());
+        ring = rings_.back().get();
+    }
+    return ring;
+}
+
+// Append a u16 length and up to `limit` bytes of s
+static char *putString(char *p, const std::string &s, size_t limit) {
+    uint16_t n = (uint16_t)std::min(s.size(), limit);
+    std::memcpy(p, &n, 2);
+    std::memcpy(p + 2, s.data(), n);
+    return p + 2 + n;
+}
+
+void EventLog::record(const Event &e) {
+    if (!open_.load(std::memory_order_relaxed)) return;
+
+    char buf[4 + 8 + 4 + 4 + 5 * 2 + kMaxInput + 4 * kMaxField + 4];
+    char *p = buf + 4;
+    int64_t ts = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(p, &ts, 8);
+    std::memcpy(p + 8, &e.latencyUs, 4);
+    std::memcpy(p + 12, &e.faqScore, 4);
+    p += 16;
+    p = putString(p, e.session, kMaxField);
+    p = putString(p, e.input, kMaxInput);
+    p = putString(p, e.intent, kMaxField);
+    p = putString(p, e.topic, kMaxField);
+    p = putString(p, e.branch, kMaxField);
+    std::memcpy(p, &e.firstByteUs, 4);
+    p += 4;
+    uint32_t size = (uint32_t)(p - buf);
+    uint32_t body = size - 4;
+    std::memcpy(buf, &body, 4);
+
+    Ring *ring = localRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t used = head - ring->tail.load(std::memory_order_acquire);
+    if (kRingBytes - used < size) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    size_t at = head % kRingBytes;
+    size_t first = std::min<size_t>(size, kRingBytes - at);
+    std::memcpy(ring->data.get() + at, buf, first);
+    std::memcpy(ring->data.get(), buf + first, size - first);
+    ring->head.store(head + size, std::memory_order_release);
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+
+    // Wake the writer early only when this ring is filling up
+    if (used + size >= kRingBytes / 2 && !wakeRequested_.exchange(true)) wake_.notify_one();
+}
+
+void EventLog::drain(std::vector<char> &batch) {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    for (auto &r : rings_) {
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t tail = r->tail.load(std::memory_order_relaxed);
+        // Records are published whole, so [tail, head) never ends mid-record
+        while (tail < head) {
+            size_t at = tail % kRingBytes;
+            size_t n = std::min<uint64_t>(head - tail, kRingBytes - at);
+            batch.insert(batch.end(), r->data.get() + at, r->data.get() + at + n);
+            tail += n;
+        }
+        r->tail.store(tail, std::memory_order_release);
+    }
+}
+
+void EventLog::writerLoop() {
+    std::vector<char> batch;
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(kFlushMs),
+                           [this]() { return stop_ || wakeRequested_.load(); });
+            stopping = stop_;
+        }
+        wakeRequested_.store(false);
+        batch.clear();
+        drain(batch);
+        if (!batch.empty()) writeBatch(batch);
+        if (stopping) return;
+    }
+}
+
+void EventLog::writeBatch(const std::vector<char> &batch) {
+    if (!lockFile()) return;
+    uint64_t size = 0;
+    std::FILE *f = openFile(size);
+    if (f && size >= maxBytes_) {
+        std::fclose(f);
+        rotate();
+        f = openFile(size);
+    }
+    if (f) {
+        bool ok = std::fwrite(batch.data(), 1, batch.size(), f) == batch.size();
+        if (std::fclose(f) == 0 && ok) bytesWritten_.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+    unlockFile();
+}
+
+#ifdef _WIN32
+
+bool EventLog::lockFile() {
+    OVERLAPPED at{};
+    return lockHandle_ && LockFileEx((HANDLE)lockHandle_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &at) != 0;
+}
+
+void EventLog::unlockFile() {
+    OVERLAPPED at{};
+    if (lockHandle_) UnlockFileEx((HANDLE)lockHandle_, 0, 1, 0, &at);
+}
+
+void EventLog::closeLock() {
+    if (lockHandle_) CloseHandle((HANDLE)lockHandle_);
+    lockHandle_ = nullptr;
+}
+
+#else
+
+bool EventLog::lockFile() {
+    if (lockFd_ < 0) return false;
+    while (flock(lockFd_, LOCK_EX) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return true;
+}
+
+void EventLog::unlockFile() {
+    if (lockFd_ >= 0) flock(lockFd_, LOCK_UN);
+}
+
+void EventLog::closeLock() {
+    if (lockFd_ >= 0) ::close(lockFd_);
+    lockFd_ = -1;
+}
+
+#endif
+
+std::FILE *EventLog::openFile(uint64_t &size) {
+    std::FILE *f = std::fopen(path_.c_str(), "ab");
+    if (!f) return nullptr;
+    std::fseek(f, 0, SEEK_END);
+    long at = std::ftell(f);
+    if (at <= 0) {
+        std::fwrite(kMagic, 1, kMagicLength, f);
+        at = kMagicLength;
+    }
+    size = (uint64_t)at;
+    return f;
+}
+
+// events.log -> events.log.1 -> ... -> events.log.<keep>; the oldest is deleted
+void EventLog::rotate() {
+    std::remove((path_ + "." + std::to_string(keep_)).c_str());
+    for (int i = keep_ - 1; i >= 1; --i) {
+        std::rename((path_ + "." + std::to_string(i)).c_str(), (path_ + "." + std::to_string(i + 1)).c_str());
+    }
+    if (keep_ > 0) std::rename(path_.c_str(), (path_ + ".1").c_str());
+    else std::remove(path_.c_str());
+    rotations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+EventLog::Stats EventLog::stats() const {
+    return {recorded_.load(), dropped_.load(), bytesWritten_.load(), rotations_.load()};
+}
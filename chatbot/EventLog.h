@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Structured log of every chat turn, for offline analysis (tools/eventlog2csv.cpp).
+//
+// record() never blocks and never allocates: each thread serializes its events into its
+// own ring buffer, and a background writer drains every ring into the log file a few
+// times a second. If a ring fills up faster than that, events are dropped and counted.
+// The file rotates by size (events.log, events.log.1, ... up to `keep` old files).
+// Processes sharing a data directory share the log: each batch is appended, and the file
+// rotated, under an exclusive lock on events.log.lock, so their records never interleave
+// and a file is rotated once, not once per process.
+//
+// File format (little-endian): the 8-byte magic "DSAEVT1\n", then one record per event:
+//   u32 size of the rest of the record
+//   i64 timestamp (microseconds since the Unix epoch)
+//   u32 latency (microseconds)
+//   f32 FAQ match score (-1 if the FAQ was not consulted)
+//   5 x (u16 length, bytes): session, raw input, intent, topic, branch
+//   u32 time to first byte (microseconds; missing from logs written before it was added)
+class EventLog {
+public:
+    struct Event {
+        std::string session;
+        std::string input;
+        std::string intent;
+        std::string topic;
+        std::string branch;     // which handler produced the reply, e.g. "cache", "faq", "learn"
+        uint32_t latencyUs = 0;
+        uint32_t firstByteUs = 0;  // until the first line of the reply was written
+        float faqScore = -1.0f;
+    };
+
+    struct Stats {
+        uint64_t recorded;
+        uint64_t dropped;
+        uint64_t bytesWritten;
+        int rotations;
+    };
+
+    static constexpr char kMagic[] = "DSAEVT1\n";  // written without the terminating NUL
+    static const size_t kMagicLength = sizeof(kMagic) - 1;
+    static const size_t kMaxInput = 512;  // longer inputs are truncated
+    static const size_t kMaxField = 128;  // session, intent, topic, branch
+
+    ~EventLog();
+
+    // Start logging to `path`; false if the file cannot be opened. Until then record() is a no-op.
+    bool open(const std::string &path, uint64_t maxBytes = 16u << 20, int keep = 3);
+    void close();  // drain everything recorded so far and stop the writer
+    bool isOpen() const { return open_.load(std::memory_order_relaxed); }
+    void record(const Event &e);
+    Stats stats() const;
+
+    // The process-wide instance. Rings are per thread, so there is only ever this one.
+    static EventLog &shared();
+
+private:
+    EventLog() = default;
+
+    static const size_t kRingBytes = 1 << 20;  // per thread: ~10k typical events
+    static const int kFlushMs = 50;
+
+    // Single producer (the owning thread), single consumer (the writer)
+    struct Ring {
+        std::unique_ptr<char[]> data{new char[kRingBytes]};
+        std::atomic<uint64_t> head{0};  // bytes produced
+        std::atomic<uint64_t> tail{0};  // bytes consumed
+    };
+
+    std::atomic<bool> open_{false};
+    std::mutex ringsMutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;  // never shrink: threads keep pointers to theirs
+
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::atomic<bool> wakeRequested_{false};  // a ring is half full; drain before the timer
+
+    std::string path_;
+    uint64_t maxBytes_ = 0;
+    int keep_ = 0;
+#ifdef _WIN32
+    void *lockHandle_ = nullptr;  // path_ + ".lock"
+#else
+    int lockFd_ = -1;
+#endif
+
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<int> rotations_{0};
+
+    Ring *localRing();
+    void writerLoop();
+    void drain(std::vector<char> &batch);
+    void writeBatch(const std::vector<char> &batch);
+    bool lockFile();
+    void unlockFile();
+    void closeLock();
+    // The current log, reopened every batch (another process may have rotated it) and started
+    // with the magic if empty; sets size to its length. With the lock held.
+    std::FILE *openFile(uint64_t &size);
+    void rotate();  // with the lock held and the log closed
+};
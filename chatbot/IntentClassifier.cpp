@@ -0,0 +1,222 @@
+#include "IntentClassifier.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+static const uint32_t kFnvOffset = 2166136261u;
+static const uint32_t kFnvPrime = 16777619u;
+
+// Words are runs of letters/digits; unigrams and adjacent bigrams are hashed (FNV-1a)
+// into kBuckets. Values are scaled so the feature vector has unit length.
+int IntentClassifier::extract(const std::string &text, Feature *out) {
+    int count = 0;
+    uint32_t prev = 0;
+    bool havePrev = false;
+    size_t i = 0, n = text.size();
+    while (i < n && count + 2 <= kMaxFeatures) {
+        while (i < n && !std::isalnum((unsigned char)text[i])) ++i;
+        if (i == n) break;
+        uint32_t h = kFnvOffset;
+        while (i < n && std::isalnum((unsigned char)text[i])) {
+            h = (h ^ (uint32_t)std::tolower((unsigned char)text[i])) * kFnvPrime;
+            ++i;
+        }
+        out[count++] = {(int)(h % kBuckets), 1.0f};
+        if (havePrev) {
+            uint32_t b = (prev * 31u + h) ^ 0x9e3779b9u;
+            b = (b ^ (b >> 15)) * 0x2c1b3c6du;
+            out[count++] = {(int)(b % kBuckets), 1.0f};
+        }
+        prev = h;
+        havePrev = true;
+    }
+    if (count > 0) {
+        float scale = 1.0f / std::sqrt((float)count);
+        for (int k = 0; k < count; ++k) out[k].value = scale;
+    }
+    return count;
+}
+
+void IntentClassifier::scores(const Feature *features, int count, float *out) const {
+    std::copy(bias_.begin(), bias_.end(), out);
+#if defined(__AVX2__) && defined(__FMA__)
+    for (int k = 0; k < stride_; k += 8) {
+        __m256 acc = _mm256_loadu_ps(out + k);
+        for (int f = 0; f < count; ++f) {
+            const float *row = &weights_[(size_t)features[f].bucket * stride_ + k];
+            acc = _mm256_fmadd_ps(_mm256_set1_ps(features[f].value), _mm256_loadu_ps(row), acc);
+        }
+        _mm256_storeu_ps(out + k, acc);
+    }
+#else
+    for (int f = 0; f < count; ++f) {
+        const float *row = &weights_[(size_t)features[f].bucket * stride_];
+        float v = features[f].value;
+        for (int k = 0; k < stride_; ++k) out[k] += v * row[k];
+    }
+#endif
+}
+
+void IntentClassifier::reset(const std::vector<std::string> &labels) {
+    labels_ = labels;
+    stride_ = ((int)labels.size() + 7) / 8 * 8;
+    weights_.assign((size_t)kBuckets * stride_, 0.0f);
+    bias_.assign(stride_, 0.0f);
+}
+
+IntentClassifier::Prediction IntentClassifier::classify(const std::string &text,
+                                                        const std::vector<std::string> *candidates) const {
+    if (!loaded()) return {std::string(), 0.0f};
+    Feature features[kMaxFeatures];
+    int count = extract(text, features);
+
+    const int kMaxStride = 64;
+    float s[kMaxStride];
+    if (stride_ > kMaxStride) return {std::string(), 0.0f};
+    scores(features, count, s);
+
+    // Softmax over the labels in play
+    bool allowed[kMaxStride];
+    int best = -1;
+    for (int k = 0; k < (int)labels_.size(); ++k) {
+        allowed[k] = !candidates || std::find(candidates->begin(), candidates->end(), labels_[k]) != candidates->end();
+        if (allowed[k] && (best < 0 || s[k] > s[best])) best = k;
+    }
+    if (best < 0) return {std::string(), 0.0f};
+    float sum = 0.0f;
+    for (int k = 0; k < (int)labels_.size(); ++k) {
+        if (allowed[k]) sum += std::exp(s[k] - s[best]);
+    }
+    return {labels_[best], 1.0f / sum};
+}
+
+void IntentClassifier::train(const std::vector<std::string> &labels, const std::vector<Example> &examples,
+                             int epochs, float rate, float l2, uint64_t seed) {
+    reset(labels);
+    int k = (int)labels.size();
+    std::vector<size_t> order(examples.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(seed);
+    std::vector<float> s(stride_), grad(stride_);
+    Feature features[kMaxFeatures];
+
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        float lr = rate / (1.0f + 0.1f * epoch);
+        for (size_t idx : order) {
+            const Example &ex = examples[idx];
+            int count = extract(ex.text, features);
+            scores(features, count, s.data());
+
+            float mx = *std::max_element(s.begin(), s.begin() + k);
+            float sum = 0.0f;
+            for (int j = 0; j < k; ++j) sum += (s[j] = std::exp(s[j] - mx));
+            for (int j = 0; j < k; ++j) grad[j] = s[j] / sum - (j == ex.label ? 1.0f : 0.0f);
+
+            for (int j = 0; j < k; ++j) bias_[j] -= lr * grad[j];
+            for (int f = 0; f < count; ++f) {
+                float *row = &weights_[(size_t)features[f].bucket * stride_];
+                for (int j = 0; j < k; ++j) row[j] -= lr * (grad[j] * features[f].value + l2 * row[j]);
+            }
+        }
+    }
+}
+
+float IntentClassifier::accuracy(const std::vector<Example> &examples) const {
+    if (examples.empty()) return 0.0f;
+    int correct = 0;
+    for (auto &ex : examples) {
+        if (classify(ex.text).intent == labels_[ex.label]) correct++;
+    }
+    return (float)correct / examples.size();
+}
+
+// Text model file:
+//   buckets <n>
+//   labels <name> <name> ...
+//   bias <w> <w> ...
+//   <bucket> <w> <w> ...     (only buckets with a non-zero weight)
+bool IntentClassifier::save(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    int k = (int)labels_.size();
+    out << "# Intent model generated by tools/train_intent.cpp; do not edit by hand\n";
+    out << "buckets " << kBuckets << "\n";
+    out << "labels";
+    for (auto &l : labels_) out << " " << l;
+    out << "\nbias";
+    char buf[32];
+    for (int j = 0; j < k; ++j) {
+        std::snprintf(buf, sizeof(buf), " %.4g", bias_[j]);
+        out << buf;
+    }
+    out << "\n";
+    for (int b = 0; b < kBuckets; ++b) {
+        const float *row = &weights_[(size_t)b * stride_];
+        bool any = false;
+        for (int j = 0; j < k; ++j) any = any || std::fabs(row[j]) >= 1e-4f;
+        if (!any) continue;
+        out << b;
+        for (int j = 0; j < k; ++j) {
+            std::snprintf(buf, sizeof(buf), " %.4g", row[j]);
+            out << buf;
+        }
+        out << "\n";
+    }
+    return (bool)out;
+}
+
+bool IntentClassifier::load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::string line, word;
+    int buckets = 0;
+    std::vector<std::string> labels;
+    std::vector<float> bias;
+    std::vector<float> rows;  // bucket followed by one weight per label, row after row
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        if (std::isdigit((unsigned char)line[0])) {
+            // Weight rows are most of the file; strtof is much cheaper than a stringstream here
+            const char *p = line.c_str();
+            char *end = nullptr;
+            for (float v = std::strtof(p, &end); end != p; v = std::strtof(p, &end)) {
+                rows.push_back(v);
+                p = end;
+            }
+            continue;
+        }
+        std::istringstream ss(line);
+        ss >> word;
+        if (word == "buckets") {
+            ss >> buckets;
+        } else if (word == "labels") {
+            while (ss >> word) labels.push_back(word);
+        } else if (word == "bias") {
+            float v;
+            while (ss >> v) bias.push_back(v);
+        }
+    }
+    // A model trained with different hashing would score garbage; ignore it
+    size_t k = labels.size();
+    if (buckets != kBuckets || k == 0 || bias.size() != k || rows.size() % (k + 1) != 0) return false;
+
+    reset(labels);
+    std::copy(bias.begin(), bias.end(), bias_.begin());
+    for (size_t r = 0; r < rows.size(); r += k + 1) {
+        int bucket = (int)rows[r];
+        if (bucket < 0 || bucket >= kBuckets) continue;
+        std::copy(rows.begin() + r + 1, rows.begin() + r + 1 + k, &weights_[(size_t)bucket * stride_]);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Second-stage intent classifier for when keyword matching finds no intent, or more
+// than one. Features are hashed word unigrams and bigrams; the model is a softmax
+// linear classifier trained offline (tools/train_intent.cpp) from data/intent_training.txt
+// and loaded from data/intent_model.txt.
+//
+// Weights are a dense float matrix stored feature-major: the row for one hash bucket
+// holds that feature's weight for every intent, padded to a multiple of 8, so scoring
+// adds one row per active feature. With AVX2+FMA available at compile time
+// (-mavx2 -mfma) each row is 8 intents per instruction; otherwise a scalar loop is used.
+class IntentClassifier {
+public:
+    static const int kBuckets = 1 << 12;
+    static const int kMaxFeatures = 64;  // longer inputs keep their first features
+
+    struct Prediction {
+        std::string intent;  // empty if no model is loaded
+        float confidence;    // softmax probability among the labels considered
+    };
+    struct Example {
+        std::string text;
+        int label;
+    };
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+    bool loaded() const { return !labels_.empty(); }
+    const std::vector<std::string> &labels() const { return labels_; }
+
+    // Best intent over all labels, or only over `candidates` (intent names) when given
+    Prediction classify(const std::string &text, const std::vector<std::string> *candidates = nullptr) const;
+
+    // Offline training: multinomial logistic regression by SGD with a seeded shuffle,
+    // so the same data and settings give the same model
+    void train(const std::vector<std::string> &labels, const std::vector<Example> &examples,
+               int epochs, float rate, float l2, uint64_t seed);
+    float accuracy(const std::vector<Example> &examples) const;
+
+private:
+    struct Feature {
+        int bucket;
+        float value;
+    };
+
+    std::vector<std::string> labels_;
+    int stride_ = 0;              // labels rounded up to a multiple of 8
+    std::vector<float> weights_;  // kBuckets x stride_
+    std::vector<float> bias_;     // stride_
+
+    static int extract(const std::string &text, Feature *out);
+    void scores(const Feature *features, int count, float *out) const;
+    void reset(const std::vector<std::string> &labels);
+};
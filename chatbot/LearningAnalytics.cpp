@@ -0,0 +1,227 @@
+#include "LearningAnalytics.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+int LearningAnalytics::difficultyIndex(const std::string &difficulty) {
+    if (difficulty == "EASY") return 0;
+    if (difficulty == "MEDIUM") return 1;
+    if (difficulty == "HARD") return 2;
+    return -1;
+}
+
+void LearningAnalytics::ScoreHistogram::add(double pct, int delta) {
+    int b = (int)std::lround(std::max(0.0, std::min(100.0, pct)));
+    buckets[b] += delta;
+    count += delta;
+}
+
+// Percentage of entries strictly below pct, counting ties as half
+double LearningAnalytics::ScoreHistogram::rankOf(double pct) const {
+    if (count <= 0) return 0.0;
+    int b = (int)std::lround(std::max(0.0, std::min(100.0, pct)));
+    int below = 0;
+    for (int i = 0; i < b; ++i) below += buckets[i];
+    return 100.0 * (below + buckets[b] / 2.0) / count;
+}
+
+double LearningAnalytics::ScoreHistogram::valueAt(double p) const {
+    if (count <= 0) return 0.0;
+    int target = (int)std::ceil(std::max(0.0, std::min(100.0, p)) / 100.0 * count);
+    if (target < 1) target = 1;
+    int seen = 0;
+    for (int i = 0; i <= 100; ++i) {
+        seen += buckets[i];
+        if (seen >= target) return i;
+    }
+    return 100.0;
+}
+
+// A whole non-negative number and nothing else ("5", not "", "5x" or "-1")
+static bool parseCount(const std::string &s, int &out) {
+    if (s.empty() || !std::isdigit((unsigned char)s[0])) return false;
+    errno = 0;
+    char *end = nullptr;
+    long v = std::strtol(s.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || v > INT_MAX) return false;
+    out = (int)v;
+    return true;
+}
+
+void LearningAnalytics::addQuizRecords(const std::string &lines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::istringstream in(lines);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (in.eof()) break;  // no newline: still being written
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        size_t pipe = line.find('|');
+        if (pipe == std::string::npos) continue;
+        std::istringstream qss(line.substr(pipe + 1));
+        std::string topic, scoreStr, difficulty, extra;
+        std::getline(qss, topic, ':');
+        std::getline(qss, scoreStr, ':');
+        std::getline(qss, difficulty, ':');
+        // A record torn by a crash ends up on a line of its own: drop anything short of a whole one
+        size_t slash = scoreStr.find('/');
+        if (pipe == 0 || topic.empty() || slash == std::string::npos || difficultyIndex(difficulty) < 0 ||
+            std::getline(qss, extra)) continue;
+        int score = 0, total = 0;
+        if (!parseCount(scoreStr.substr(0, slash), score) || !parseCount(scoreStr.substr(slash + 1), total) ||
+            total <= 0 || score > total) continue;
+        recordQuizLocked(line.substr(0, pipe), topic, difficulty, score, total);
+    }
+}
+
+void LearningAnalytics::addSessionRecords(const std::string &lines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::istringstream in(lines);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (in.eof()) break;  // no newline: still being written
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        size_t pipe = line.find("|sessions:");
+        // A record torn by a crash runs into the next one: "ann|sess" + "bob|sessions:queue" leaves
+        // a '|' in the user, "ann|sessions:st" + "bob|sessions:queue" an unknown topic
+        if (pipe == std::string::npos || pipe == 0 || line.find('|') != pipe) continue;
+        std::vector<std::string> topics;
+        std::istringstream lss(line.substr(pipe + 10));
+        std::string topic;
+        bool whole = true;
+        while (whole && std::getline(lss, topic, ',')) {
+            if (topic.empty()) continue;
+            whole = knownTopic_ ? knownTopic_(topic) : topic.find_first_of("|:") == std::string::npos;
+            topics.push_back(topic);
+        }
+        if (!whole) continue;
+        UserStats &u = users_[line.substr(0, pipe)];
+        u.studied.insert(topics.begin(), topics.end());
+    }
+}
+
+void LearningAnalytics::setKnownTopics(std::function<bool(const std::string &)> knownTopic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    knownTopic_ = std::move(knownTopic);
+}
+
+void LearningAnalytics::loadInBackground(std::function<void()> load) {
+    loading_ = std::async(std::launch::async, std::move(load)).share();
+}
+
+void LearningAnalytics::waitUntilLoaded() const {
+    if (loading_.valid()) loading_.wait();
+}
+
+void LearningAnalytics::recordQuizLocked(const std::string &username, const std::string &topic,
+                                         const std::string &difficulty, int score, int total) {
+    double pct = 100.0 * score / total;  // addQuizRecords only passes 0 <= score <= total, total > 0
+    UserStats &u = users_[username];
+
+    // Replace this user's previous mean in the class-wide histogram
+    if (u.attempts > 0) userMeans_.add(u.meanPct(), -1);
+    u.entries.push_back({topic, difficulty, score, total});
+    u.attempts++;
+    u.sumPct += pct;
+    userMeans_.add(u.meanPct(), +1);
+
+    TopicStats &t = u.topics[topic];
+    if (t.attempts > 0) u.byMean.erase({t.meanPct(), topic});
+    t.attempts++;
+    t.sumPct += pct;
+    u.byMean.insert({t.meanPct(), topic});
+
+    int d = difficultyIndex(difficulty);
+    if (d >= 0) {
+        DifficultyStats &ds = t.byDifficulty[d];
+        ds.attempts++;
+        ds.sumPct += pct;
+        ds.bestPct = std::max(ds.bestPct, pct);
+    }
+
+    if (pct >= kPassPct) {
+        u.currentStreak++;
+        u.bestStreak = std::max(u.bestStreak, u.currentStreak);
+    } else {
+        u.currentStreak = 0;
+    }
+}
+
+bool LearningAnalytics::getSummary(const std::string &username, Summary &out) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it == users_.end()) return false;
+    const UserStats &u = it->second;
+    out.attempts = u.attempts;
+    out.meanPct = u.meanPct();
+    out.currentStreak = u.currentStreak;
+    out.bestStreak = u.bestStreak;
+    return true;
+}
+
+void LearningAnalytics::studiedTopics(const std::string &username, std::vector<std::string> &out) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it != users_.end()) out.insert(out.end(), it->second.studied.begin(), it->second.studied.end());
+}
+
+void LearningAnalytics::forEachEntry(const std::string &username, const std::function<void(const Entry &)> &fn) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it == users_.end()) return;
+    for (auto &e : it->second.entries) fn(e);
+}
+
+void LearningAnalytics::forEachTopic(const std::string &username,
+                                     const std::function<void(const std::string &, const TopicStats &)> &fn) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it == users_.end()) return;
+    for (auto &t : it->second.topics) fn(t.first, t.second);
+}
+
+double LearningAnalytics::topicMean(const std::string &username, const std::string &topic) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it == users_.end()) return -1.0;
+    auto t = it->second.topics.find(topic);
+    if (t == it->second.topics.end() || t->second.attempts == 0) return -1.0;
+    return t->second.meanPct();
+}
+
+std::vector<std::pair<std::string, double>> LearningAnalytics::weakestTopics(const std::string &username, size_t k) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<std::string, double>> out;
+    auto it = users_.find(username);
+    if (it == users_.end()) return out;
+    for (auto &p : it->second.byMean) {
+        if (out.size() >= k) break;
+        out.push_back({p.second, p.first});
+    }
+    return out;
+}
+
+double LearningAnalytics::classPercentileRank(const std::string &username) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(username);
+    if (it == users_.end() || it->second.attempts == 0) return 0.0;
+    return userMeans_.rankOf(it->second.meanPct());
+}
+
+double LearningAnalytics::classPercentile(double p) const {
+    waitUntilLoaded();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return userMeans_.valueAt(p);
+}
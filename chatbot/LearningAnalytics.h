@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Per-user and per-topic learning statistics.
+// Aggregates are updated incrementally as quiz results and study sessions are
+// recorded, so every query answers from memory and never re-reads the user files.
+class LearningAnalytics {
+public:
+    // Stats for one difficulty level (EASY / MEDIUM / HARD) of one topic
+    struct DifficultyStats {
+        int attempts = 0;
+        double sumPct = 0.0;
+        double bestPct = 0.0;
+        double meanPct() const { return attempts ? sumPct / attempts : 0.0; }
+    };
+
+    struct TopicStats {
+        std::array<DifficultyStats, 3> byDifficulty;  // indexed EASY, MEDIUM, HARD
+        int attempts = 0;
+        double sumPct = 0.0;
+        double meanPct() const { return attempts ? sumPct / attempts : 0.0; }
+    };
+
+    // One saved quiz result, kept so progress can be listed without re-reading files
+    struct Entry {
+        std::string topic;
+        std::string difficulty;
+        int score;
+        int total;
+    };
+
+    // A user's overall figures, without their quiz history: cheap to copy on every turn
+    struct Summary {
+        int attempts = 0;
+        double meanPct = 0.0;
+        int currentStreak = 0;  // consecutive passed quizzes (>= kPassPct)
+        int bestStreak = 0;
+    };
+
+    static constexpr double kPassPct = 60.0;
+
+    ~LearningAnalytics() { waitUntilLoaded(); }  // a background load still writes the members
+
+    // Fold in complete record lines read from quiz_progress.txt (username|topic:score/total:difficulty)
+    // and topics_history.txt (username|sessions:topic1,topic2,...). ProgressStore calls these for
+    // every record appended to the files, by this process or another one; comment, malformed and
+    // unterminated lines are skipped (a quiz record needs a user, a topic, whole numbers
+    // 0 <= score <= total with total > 0, and EASY, MEDIUM or HARD; a session record needs a user
+    // without '|' and only topics knownTopic accepts). They do not wait for the background load,
+    // which is made of these calls.
+    void addQuizRecords(const std::string &lines);
+    void addSessionRecords(const std::string &lines);
+    // Topic keys session records may name; set before the first add*Records call. All are accepted without it.
+    void setKnownTopics(std::function<bool(const std::string &)> knownTopic);
+    // Run load (migrating old files, then reading the progress files) on a background thread.
+    // Every query below waits for it, so callers never see half-loaded stats.
+    void loadInBackground(std::function<void()> load);
+    void waitUntilLoaded() const;
+
+    // Queries. Returns false if the user has no recorded data.
+    bool getSummary(const std::string &username, Summary &out) const;
+    void studiedTopics(const std::string &username, std::vector<std::string> &out) const;  // appends to out
+    // Walk the user's quiz history, oldest first, and their per-topic stats, by name, under the
+    // lock instead of copying them out; fn must not call back into this object
+    void forEachEntry(const std::string &username, const std::function<void(const Entry &)> &fn) const;
+    void forEachTopic(const std::string &username,
+                      const std::function<void(const std::string &, const TopicStats &)> &fn) const;
+    double topicMean(const std::string &username, const std::string &topic) const;  // -1 if never quizzed
+    std::vector<std::pair<std::string, double>> weakestTopics(const std::string &username, size_t k) const;
+
+    // Class-wide percentile rank (0-100) of a user's mean score among all users,
+    // and the mean score at a given class percentile.
+    double classPercentileRank(const std::string &username) const;
+    double classPercentile(double p) const;
+
+    static int difficultyIndex(const std::string &difficulty);
+
+private:
+    // Fixed-bucket histogram over 0..100 %. Mergeable and supports removal,
+    // so a user's previous mean can be replaced when a new result arrives.
+    struct ScoreHistogram {
+        std::array<int, 101> buckets{};
+        int count = 0;
+        void add(double pct, int delta);
+        double rankOf(double pct) const;
+        double valueAt(double p) const;
+    };
+
+    struct UserStats {
+        std::vector<Entry> entries;
+        std::map<std::string, TopicStats> topics;
+        std::set<std::pair<double, std::string>> byMean;  // (mean %, topic), weakest first
+        std::set<std::string> studied;                    // topics from saved sessions
+        int attempts = 0;
+        double sumPct = 0.0;
+        int currentStreak = 0;
+        int bestStreak = 0;
+        double meanPct() const { return attempts ? sumPct / attempts : 0.0; }
+    };
+
+    mutable std::mutex mutex_;
+    std::shared_future<void> loading_;  // set by loadInBackground()
+    std::unordered_map<std::string, UserStats> users_;
+    ScoreHistogram userMeans_;
+    std::function<bool(const std::string &)> knownTopic_;
+
+    void recordQuizLocked(const std::string &username, const std::string &topic,
+                          const std::string &difficulty, int score, int total);
+};
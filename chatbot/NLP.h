@@ -1,7 +1,21 @@
-#pragma once
-#include <string>
-#include <utility>
-
-// Very small NLP-lite: extracts intent and topic from a user sentence.
-// Returns pair<intent, topic>. If not found, returns "unknown".
-std::pair<std::string, std::string> parseIntentAndTopic(const std::string &input);
\ No newline at end of file
+#pragma once
+#include "IntentClassifier.h"
+#include "TopicRegistry.h"
+#include <string>
+#include <utility>
+
+// The intents parseIntentAndTopic() reports. ChatEngine dispatches on the enum; the names are
+// what the keyword table, the classifier model, the event log and the response cache use.
+enum class Intent { Unknown, Learn, Definition, Detail, Example, Pseudocode, Quiz, Difference, Recommend, Progress, Exit, Count };
+Intent intentFromName(const std::string &name);  // Intent::Unknown if it is not one
+const char *intentName(Intent intent);
+// True if phrase occurs in text with no letter or digit directly before or after it
+bool containsWords(const std::string &text, const std::string &phrase);
+
+// Very small NLP-lite: extracts intent and topic from a user sentence.
+// Topics come from the registry's alias matcher; several are joined with '|' in order of mention.
+// Intent keywords decide when exactly one intent matches; when several match, or none, the
+// classifier (if a model is loaded) picks among them.
+// Returns pair<intent, topic>: Intent::Unknown and "unknown" when not found.
+std::pair<Intent, std::string> parseIntentAndTopic(const std::string &input, const TopicRegistry &topics,
+                                                   const IntentClassifier *classifier = nullptr);
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "ProgressStore.h"
+#include <fstream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char *kQuizHeader = "# Quiz progress file\n# Format: username|topic:score/total:difficulty\n";
+static const char *kSessionHeader = "# Topics history file\n# Format: username|sessions:topic1,topic2,...\n";
+
+ProgressStore::~ProgressStore() {
+    closeFile(quiz_);
+    closeFile(sessions_);
+}
+
+bool ProgressStore::open(const std::filesystem::path &userDir) {
+    bool ok = openFile(quiz_, userDir / "quiz_progress.txt", kQuizHeader);
+    return openFile(sessions_, userDir / "topics_history.txt", kSessionHeader) && ok;
+}
+
+bool ProgressStore::openFile(File &f, const std::filesystem::path &path, const std::string &header) {
+    closeFile(f);
+    f.path = path;
+    f.readOffset = 0;
+#ifdef _WIN32
+    // Append-only access: every write lands at the current end of the file
+    HANDLE h = CreateFileW(path.c_str(), FILE_READ_DATA | FILE_APPEND_DATA | SYNCHRONIZE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    f.handle = h;
+#else
+    f.fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (f.fd < 0) return false;
+#endif
+    // Two processes may create the file at once; only the first one under the lock writes the header
+    return append(f, header, true);
+}
+
+void ProgressStore::closeFile(File &f) {
+#ifdef _WIN32
+    if (f.handle) CloseHandle((HANDLE)f.handle);
+    f.handle = nullptr;
+#else
+    if (f.fd >= 0) ::close(f.fd);
+    f.fd = -1;
+#endif
+}
+
+#ifdef _WIN32
+
+bool ProgressStore::append(File &f, const std::string &records, bool onlyIfEmpty) {
+    HANDLE h = (HANDLE)f.handle;
+    if (!h) return false;
+    // Lock one byte far past any real file end. Windows locks are mandatory, so locking the
+    // records themselves would block readers; this byte only serializes the writers.
+    OVERLAPPED lockAt{};
+    lockAt.OffsetHigh = 0x80000000u;
+    if (!LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &lockAt)) return false;
+
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(h, &size) != 0;
+    std::string data;
+    if (ok && size.QuadPart > 0) {
+        if (onlyIfEmpty) {
+            UnlockFileEx(h, 0, 1, 0, &lockAt);
+            return true;
+        }
+        // End a line torn by a crash, so it does not swallow this record
+        OVERLAPPED lastAt{};
+        lastAt.Offset = (DWORD)(size.QuadPart - 1);
+        lastAt.OffsetHigh = (DWORD)((size.QuadPart - 1) >> 32);
+        char last = '\n';
+        DWORD got = 0;
+        if (ReadFile(h, &last, 1, &got, &lastAt) && got == 1 && last != '\n') data += '\n';
+    }
+    data += records;
+    DWORD written = 0;
+    ok = ok && WriteFile(h, data.data(), (DWORD)data.size(), &written, nullptr) && written == data.size();
+    UnlockFileEx(h, 0, 1, 0, &lockAt);
+    return ok;
+}
+
+#else
+
+bool ProgressStore::append(File &f, const std::string &records, bool onlyIfEmpty) {
+    if (f.fd < 0) return false;
+    while (flock(f.fd, LOCK_EX) < 0) {
+        if (errno != EINTR) return false;
+    }
+
+    struct stat st;
+    bool ok = fstat(f.fd, &st) == 0;
+    std::string data;
+    if (ok && st.st_size > 0) {
+        if (onlyIfEmpty) {
+            flock(f.fd, LOCK_UN);
+            return true;
+        }
+        // End a line torn by a crash, so it does not swallow this record
+        char last = '\n';
+        if (pread(f.fd, &last, 1, st.st_size - 1) == 1 && last != '\n') data += '\n';
+    }
+    data += records;
+    // One write: O_APPEND places it at the end as a whole
+    const char *p = data.data();
+    size_t left = data.size();
+    while (ok && left > 0) {
+        ssize_t n = ::write(f.fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    flock(f.fd, LOCK_UN);
+    return ok;
+}
+
+#endif
+
+bool ProgressStore::appendQuiz(const std::string &username, const std::string &topic, int score, int total,
+                               const std::string &difficulty) {
+    // Format: username|topic:score/total:difficulty
+    std::string line = username + "|" + topic + ":" + std::to_string(score) + "/" + std::to_string(total) + ":" +
+                       difficulty + "\n";
+    bool ok = append(quiz_, line);
+    sync();
+    return ok;
+}
+
+bool ProgressStore::appendSession(const std::string &username, const std::vector<std::string> &topics) {
+    // Format: username|sessions:topic1,topic2,...
+    std::string line = username + "|sessions:";
+    for (size_t i = 0; i < topics.size(); ++i) {
+        if (i > 0) line += ",";
+        line += topics[i];
+    }
+    line += "\n";
+    bool ok = append(sessions_, line);
+    sync();
+    return ok;
+}
+
+static std::string joinLines(const std::vector<std::string> &lines) {
+    std::string out;
+    for (auto &l : lines) out += l + "\n";
+    return out;
+}
+
+bool ProgressStore::appendQuizLines(const std::vector<std::string> &lines) {
+    return lines.empty() || append(quiz_, joinLines(lines));
+}
+
+bool ProgressStore::appendSessionLines(const std::vector<std::string> &lines) {
+    return lines.empty() || append(sessions_, joinLines(lines));
+}
+
+std::string ProgressStore::readNew(File &f) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(f.path, ec);
+    if (ec || size <= f.readOffset) return std::string();
+
+    std::ifstream in(f.path, std::ios::binary);
+    if (!in.seekg((std::streamoff)f.readOffset)) return std::string();
+    std::string data((size_t)(size - f.readOffset), '\0');
+    in.read(&data[0], (std::streamsize)data.size());
+    data.resize((size_t)in.gcount());
+
+    // A writer may be halfway through the last line; it is read once it is complete
+    size_t end = data.rfind('\n');
+    if (end == std::string::npos) return std::string();
+    data.resize(end + 1);
+    f.readOffset += data.size();
+    return data;
+}
+
+void ProgressStore::sync() {
+    std::lock_guard<std::mutex> lock(syncMutex_);
+    syncLocked();
+}
+
+void ProgressStore::refresh() {
+    using Clock = std::chrono::steady_clock;
+    int64_t now = Clock::now().time_since_epoch().count();
+    if (now - lastSync_.load(std::memory_order_relaxed) <
+        std::chrono::duration_cast<Clock::duration>(kRefreshInterval).count())
+        return;
+    std::unique_lock<std::mutex> lock(syncMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) return;  // a sync (maybe the startup load) is already reading
+    syncLocked();
+}
+
+void ProgressStore::syncLocked() {
+    std::string quiz = readNew(quiz_);
+    if (!quiz.empty()) analytics_.addQuizRecords(quiz);
+    std::string sessions = readNew(sessions_);
+    if (!sessions.empty()) analytics_.addSessionRecords(sessions);
+    lastSync_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "LearningAnalytics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The progress files of one user folder (quiz_progress.txt, topics_history.txt), shared by every
+// chatbot process running on that folder.
+// Writers append each record as one line with a single write while holding an exclusive lock on
+// the file (flock, LockFileEx), so records from concurrent processes are never interleaved or lost.
+// A line torn by a crash is ended before the next record, and readers skip it.
+// Readers take no lock: they read whole lines up to the end of the file and leave an unfinished
+// last line for the next read, so they never block a writer.
+// The analytics follow the files: sync() folds in every record appended since the last sync,
+// whether this process or another one wrote it.
+class ProgressStore {
+public:
+    explicit ProgressStore(LearningAnalytics &analytics) : analytics_(analytics) {}
+    ~ProgressStore();
+    ProgressStore(const ProgressStore &) = delete;
+    ProgressStore &operator=(const ProgressStore &) = delete;
+
+    // Open both files in userDir, creating them (with their comment header) if they are missing
+    bool open(const std::filesystem::path &userDir);
+
+    // Append a record and sync, so the analytics include it on return. False if the write failed.
+    bool appendQuiz(const std::string &username, const std::string &topic, int score, int total,
+                    const std::string &difficulty);
+    bool appendSession(const std::string &username, const std::vector<std::string> &topics);
+    // Append ready-made record lines (no newline) without syncing, e.g. migrated from progress.txt
+    bool appendQuizLines(const std::vector<std::string> &lines);
+    bool appendSessionLines(const std::vector<std::string> &lines);
+
+    void sync();
+    // sync() if the last one is older than kRefreshInterval, unless one is running right now.
+    // Cheap enough to call on every turn; picks up what other processes saved.
+    void refresh();
+
+    const std::filesystem::path &quizPath() const { return quiz_.path; }
+    const std::filesystem::path &sessionPath() const { return sessions_.path; }
+
+    static constexpr std::chrono::milliseconds kRefreshInterval{200};
+
+private:
+    struct File {
+        std::filesystem::path path;
+#ifdef _WIN32
+        void *handle = nullptr;  // nullptr when not open
+#else
+        int fd = -1;
+#endif
+        uint64_t readOffset = 0;  // bytes already folded into the analytics (whole lines only)
+    };
+
+    LearningAnalytics &analytics_;
+    File quiz_;
+    File sessions_;
+    std::mutex syncMutex_;
+    std::atomic<int64_t> lastSync_{0};  // steady_clock ticks
+
+    static bool openFile(File &f, const std::filesystem::path &path, const std::string &header);
+    static void closeFile(File &f);
+    // Append whole lines under the file lock. With onlyIfEmpty, leaves a file that has content alone.
+    static bool append(File &f, const std::string &records, bool onlyIfEmpty = false);
+    // Complete lines appended since readOffset; advances readOffset past them
+    static std::string readNew(File &f);
+    void syncLocked();
+};
@@ -0,0 +1,376 @@
+#include "QuizBank.h"
+#include "LearningAnalytics.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+static std::string trim(const std::string &s) {
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+}
+
+static std::string lower(std::string s) {
+    for (auto &c : s) c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+std::string QuizBank::normalize(const std::string &s) {
+    std::string r;
+    for (char c : s) if (!isspace((unsigned char)c)) r += (char)std::tolower((unsigned char)c);
+    return r;
+}
+
+std::string QuizBank::words(const std::string &s) {
+    static const std::string kPunct = ",.;:!?\"'";
+    std::string r, w;
+    std::istringstream in(lower(s));
+    while (in >> w) {
+        size_t b = w.find_first_not_of(kPunct);
+        if (b == std::string::npos) continue;
+        size_t e = w.find_last_not_of(kPunct);
+        if (!r.empty()) r += ' ';
+        r.append(w, b, e - b + 1);
+    }
+    return r;
+}
+
+// The same word, or one is the other plus a plural "s"/"es" ("queues" for "queue"); words
+// under three letters must match exactly, so "ns" is not "n"
+static bool sameWord(const std::string &a, const std::string &b) {
+    if (a == b) return true;
+    const std::string &shorter = a.size() < b.size() ? a : b;
+    const std::string &longer = a.size() < b.size() ? b : a;
+    if (shorter.size() < 3 || longer.compare(0, shorter.size(), shorter) != 0) return false;
+    std::string suffix = longer.substr(shorter.size());
+    return suffix == "s" || suffix == "es";
+}
+
+static std::vector<std::string> split(const std::string &words) {
+    std::vector<std::string> out;
+    std::istringstream in(words);
+    for (std::string w; in >> w;) out.push_back(w);
+    return out;
+}
+
+// Whether needle occurs in haystack (both words()) as whole words, allowing plurals
+static bool hasWords(const std::string &haystack, const std::string &needle) {
+    std::vector<std::string> h = split(haystack), n = split(needle);
+    if (n.empty()) return false;
+    for (size_t at = 0; at + n.size() <= h.size(); ++at) {
+        size_t i = 0;
+        while (i < n.size() && sameWord(h[at + i], n[i])) ++i;
+        if (i == n.size()) return true;
+    }
+    return false;
+}
+
+bool QuizBank::accepts(const Question &q, const std::string &answer) {
+    std::string given = words(answer);
+    if (given.empty()) return false;
+    std::string compact = normalize(given);
+    for (auto &key : q.keys) {
+        if (compact == normalize(key) || hasWords(given, key)) return true;
+        if (!q.generated && given.size() >= kMinPartial && hasWords(key, given)) return true;
+    }
+    return false;
+}
+
+// keys: the acceptable answers when there are several, else just a
+static QuizBank::Question makeQuestion(const std::string &q, const std::string &a, bool generated,
+                                       const std::vector<std::string> &keys = {}) {
+    QuizBank::Question question{q, a, {}, generated};
+    for (auto &k : keys.empty() ? std::vector<std::string>{a} : keys) {
+        std::string w = QuizBank::words(k);
+        if (!w.empty() && std::find(question.keys.begin(), question.keys.end(), w) == question.keys.end())
+            question.keys.push_back(w);
+    }
+    return question;
+}
+
+void QuizBank::buildInBackground(std::function<void()> build) {
+    building_ = std::async(std::launch::async, std::move(build)).share();
+}
+
+void QuizBank::waitUntilBuilt() const {
+    if (building_.valid()) building_.wait();
+}
+
+size_t QuizBank::build(const TopicRegistry &topics, const std::filesystem::path &topicsDir,
+                       const std::function<std::string(const std::string &)> &content) {
+    generic_ = {
+        makeQuestion("What is a data structure?", "a way to organize data", false),
+        makeQuestion("Name a linear data structure.", "array", false),
+        makeQuestion("What does LIFO stand for?", "last in first out", false),
+        makeQuestion("What does FIFO stand for?", "first in first out", false),
+        makeQuestion("Define algorithm", "step by step procedure", false),
+    };
+
+    size_t generated = 0;
+    for (size_t id = 0; id < topics.size(); ++id) {
+        const TopicRegistry::Topic &topic = topics.topic((int)id);
+        std::array<Pool, 3> &pools = pools_[topic.key];
+        loadAuthored(topicsDir / (topic.key + "_quiz.txt"), pools);
+        size_t authored = pools[0].size() + pools[1].size() + pools[2].size();
+        generate(topic, content(topic.key), pools);
+        generated += pools[0].size() + pools[1].size() + pools[2].size() - authored;
+    }
+    return generated;
+}
+
+// Questions after a [EASY] / [MEDIUM] / [HARD] marker belong to that difficulty; questions
+// before any marker (files written without them) to all three
+void QuizBank::loadAuthored(const std::filesystem::path &path, std::array<Pool, 3> &pools) {
+    std::ifstream in(path);
+    if (!in) return;
+    int difficulty = -1;
+    std::string line, curQ;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.size() > 2 && line.front() == '[' && line.back() == ']') {
+            int d = LearningAnalytics::difficultyIndex(line.substr(1, line.size() - 2));
+            if (d >= 0) difficulty = d;
+            continue;
+        }
+        if (line.rfind("Q:", 0) == 0) {
+            curQ = trim(line.substr(2));
+        } else if (line.rfind("A:", 0) == 0 && !curQ.empty()) {
+            Question q = makeQuestion(curQ, trim(line.substr(2)), false);
+            if (difficulty >= 0) {
+                pools[difficulty].push_back(q);
+            } else {
+                for (auto &p : pools) p.push_back(q);
+            }
+            curQ.clear();
+        }
+    }
+}
+
+// Heading line ("Definition:", "Pseudocode: Binary Search") and the paragraph after it, up to
+// a blank line or the next heading. Text after the colon on the heading line is kept in inlineText.
+struct Section {
+    std::string inlineText;
+    std::vector<std::string> lines;
+};
+
+static std::vector<Section> findSections(const std::vector<std::string> &lines, const std::string &heading) {
+    std::vector<Section> out;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (lower(lines[i]).rfind(heading, 0) != 0) continue;
+        Section s;
+        size_t colon = lines[i].find(':');
+        if (colon != std::string::npos) s.inlineText = trim(lines[i].substr(colon + 1));
+        for (size_t j = i + 1; j < lines.size() && !trim(lines[j]).empty(); ++j) {
+            std::string l = lower(trim(lines[j]));
+            if (l.rfind("pseudocode", 0) == 0 || l.rfind("example", 0) == 0 || l.rfind("definition", 0) == 0 ||
+                l.rfind("faq", 0) == 0)
+                break;
+            s.lines.push_back(lines[j]);
+        }
+        out.push_back(s);
+    }
+    return out;
+}
+
+static const std::set<std::string> kCommonWords = {
+    "about", "after", "allows", "along", "also", "among", "another", "because", "before", "being",
+    "between", "called", "consisting", "could", "designated", "each", "either", "elements", "every",
+    "first", "following", "other", "their", "there", "these", "those", "through", "under", "using",
+    "where", "which", "while", "whose", "within", "without", "would",
+    "structure", "structures",  // "data structure" gives itself away
+};
+
+// Fill in the blank on the first sentence of each Definition: up to two words, longest first,
+// that appear once in the sentence and do not name the topic itself
+static void definitionQuestions(const TopicRegistry::Topic &topic, const std::vector<std::string> &lines,
+                                std::vector<QuizBank::Question> &pool) {
+    std::set<std::string> own;
+    for (auto &alias : topic.aliases) {
+        std::istringstream ws(lower(alias));
+        std::string w;
+        while (ws >> w) own.insert(w);
+    }
+    std::istringstream ks(lower(topic.key));
+    for (std::string w; std::getline(ks, w, '_');) own.insert(w);
+
+    for (auto &section : findSections(lines, "definition")) {
+        // The prose before the first bullet or sub-heading
+        std::string text = section.inlineText;
+        for (auto &raw : section.lines) {
+            std::string l = trim(raw);
+            if (l.rfind("- ", 0) == 0 || l.back() == ':') break;
+            text += (text.empty() ? "" : " ") + l;
+        }
+        // Drop a leading label ("Binary Heap: A heap is ...")
+        size_t label = text.find(':');
+        if (label != std::string::npos && label < 25 && text.find('.') > label) text = trim(text.substr(label + 1));
+        size_t stop = text.find(". ");
+        std::string sentence = stop == std::string::npos ? text : text.substr(0, stop + 1);
+        if (sentence.size() < 30 || sentence.size() > 200) continue;
+
+        // Candidate words: letters only, 5+ long, once in the sentence
+        std::vector<std::pair<size_t, size_t>> words;  // (start, length)
+        std::map<std::string, int> seen;
+        for (size_t i = 0; i < sentence.size();) {
+            if (!std::isalpha((unsigned char)sentence[i])) { ++i; continue; }
+            size_t j = i;
+            while (j < sentence.size() && std::isalpha((unsigned char)sentence[j])) ++j;
+            std::string w = lower(sentence.substr(i, j - i));
+            seen[w]++;
+            bool joined = (i > 0 && sentence[i - 1] == '-') || (j < sentence.size() && sentence[j] == '-');
+            if (w.size() >= 5 && !joined && !own.count(w) && !own.count(w.substr(0, w.size() - 1)) &&
+                !kCommonWords.count(w))
+                words.push_back({i, j - i});
+            i = j;
+        }
+        words.erase(std::remove_if(words.begin(), words.end(), [&](const std::pair<size_t, size_t> &w) {
+                        return seen[lower(sentence.substr(w.first, w.second))] > 1;
+                    }), words.end());
+        std::stable_sort(words.begin(), words.end(), [](const std::pair<size_t, size_t> &a,
+                                                        const std::pair<size_t, size_t> &b) {
+            return a.second > b.second;
+        });
+        for (size_t k = 0; k < words.size() && k < 2; ++k) {
+            std::string blanked = sentence;
+            blanked.replace(words[k].first, words[k].second, "_____");
+            pool.push_back(makeQuestion("Fill in the blank: " + blanked, sentence.substr(words[k].first, words[k].second), true));
+        }
+    }
+}
+
+static std::string complexityName(const std::string &bigO) {
+    std::string n = QuizBank::normalize(bigO);
+    if (n == "o(1)") return "constant";
+    if (n == "o(logn)") return "logarithmic";
+    if (n == "o(n)") return "linear";
+    if (n == "o(nlogn)") return "linearithmic";
+    if (n == "o(n^2)") return "quadratic";
+    return std::string();
+}
+
+// "O(...)" starting at pos, parentheses balanced; empty if there is none
+static std::string bigOAt(const std::string &s, size_t pos) {
+    int depth = 0;
+    for (size_t i = pos + 1; i < s.size(); ++i) {
+        if (s[i] == '(') depth++;
+        else if (s[i] == ')' && --depth == 0) return s.substr(pos, i - pos + 1);
+    }
+    return std::string();
+}
+
+// "- Access by index: O(1)" asks for the complexity; "- O(log n): logarithmic" for the name.
+// Lines quoting more than one bound ("insert O(log n), extract O(log n)") are skipped.
+static void complexityQuestions(const std::string &name, const std::vector<std::string> &lines,
+                                std::vector<QuizBank::Question> &pool) {
+    for (auto &raw : lines) {
+        std::string line = trim(raw);
+        if (line.rfind("- ", 0) != 0) continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string label = trim(line.substr(2, colon - 2));
+        std::string value = trim(line.substr(colon + 1));
+        size_t first = value.find("O(");
+        if (first == std::string::npos || value.find("O(", first + 2) != std::string::npos) continue;
+
+        // A short operation name: not "Time" / "Space complexity", nor a sentence
+        std::string low = lower(label);
+        if (label.find("O(") != std::string::npos || label.size() < 4 || value.size() > 40 || low == "time" ||
+            low == "space" || low.find("complexit") != std::string::npos || std::count(low.begin(), low.end(), ' ') > 3)
+            continue;
+        std::string bigO = bigOAt(value, first);
+        if (bigO.empty()) continue;
+        // "O(n log n)", "O(nlogn)" or "linearithmic", each on its own
+        std::string answer = bigO;
+        std::vector<std::string> keys = {bigO, QuizBank::normalize(bigO)};
+        std::string named = complexityName(bigO);
+        if (!named.empty()) {
+            answer += ", " + named;
+            keys.push_back(named);
+        }
+        pool.push_back(makeQuestion("In " + name + ", what is the time complexity of: " + label + "?", answer, true, keys));
+    }
+    for (auto &raw : lines) {
+        std::string line = trim(raw);
+        if (line.rfind("- O(", 0) != 0) continue;
+        size_t colon = line.find("):");
+        if (colon == std::string::npos) continue;
+        std::string bigO = line.substr(2, colon - 1);
+        std::string value = trim(line.substr(colon + 2));
+        if (value.empty() || value.size() > 24 || value.find("O(") != std::string::npos) continue;
+        pool.push_back(makeQuestion("What is " + bigO + " complexity called?", value, true));
+    }
+}
+
+// The missing line of each Pseudocode section: the candidate nearest its middle, among lines
+// that do something (an assignment or a call) and appear once
+static void pseudocodeQuestions(const std::string &name, const std::vector<std::string> &lines,
+                                std::vector<QuizBank::Question> &pool) {
+    for (auto &section : findSections(lines, "pseudocode")) {
+        if (section.lines.size() < 3) continue;
+        int best = -1;
+        double middle = (section.lines.size() - 1) / 2.0;
+        for (size_t i = 0; i < section.lines.size(); ++i) {
+            std::string t = trim(section.lines[i]);
+            if (t.size() < 6 || t.size() > 40 || t.rfind("function", 0) == 0 || t.rfind("procedure", 0) == 0) continue;
+            if (t.find('=') == std::string::npos && t.find('(') == std::string::npos) continue;
+            if (std::count_if(section.lines.begin(), section.lines.end(),
+                              [&](const std::string &l) { return trim(l) == t; }) > 1)
+                continue;
+            if (best < 0 || std::abs(i - middle) < std::abs(best - middle)) best = (int)i;
+        }
+        if (best < 0) continue;
+
+        std::string title = section.inlineText.empty() ? name : section.inlineText;
+        std::string q = "Fill in the missing line of this pseudocode (" + title + "):";
+        for (size_t i = 0; i < section.lines.size(); ++i) {
+            const std::string &l = section.lines[i];
+            if ((int)i == best) q += "\n" + l.substr(0, l.find_first_not_of(" \t")) + "_____";
+            else q += "\n" + l;
+        }
+        pool.push_back(makeQuestion(q, trim(section.lines[best]), true));
+    }
+}
+
+void QuizBank::generate(const TopicRegistry::Topic &topic, const std::string &text, std::array<Pool, 3> &pools) {
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+    std::string name = topic.key;
+    std::replace(name.begin(), name.end(), '_', ' ');
+
+    definitionQuestions(topic, lines, pools[0]);
+    complexityQuestions(name, lines, pools[1]);
+    pseudocodeQuestions(name, lines, pools[2]);
+}
+
+const QuizBank::Pool *QuizBank::pool(const std::string &topic, const std::string &difficulty) const {
+    waitUntilBuilt();
+    auto it = pools_.find(topic);
+    int d = LearningAnalytics::difficultyIndex(difficulty);
+    if (it == pools_.end() || d < 0 || it->second[d].empty()) return nullptr;
+    return &it->second[d];
+}
+
+QuizBank::Quiz QuizBank::quiz(const std::string &topic, const std::string &difficulty, uint32_t variant) const {
+    const Pool *p = pool(topic, difficulty);
+    if (!p) p = &generic_;
+    Quiz out;
+    size_t n = std::min(kQuizLength, p->size());
+    size_t start = p->size() > kQuizLength ? (size_t)variant * kQuizLength % p->size() : 0;
+    for (size_t i = 0; i < n; ++i) out.push_back(&(*p)[(start + i) % p->size()]);
+    return out;
+}
+
+size_t QuizBank::poolSize(const std::string &topic, const std::string &difficulty) const {
+    const Pool *p = pool(topic, difficulty);
+    return p ? p->size() : 0;
+}
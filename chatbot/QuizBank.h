@@ -0,0 +1,76 @@
+#pragma once
+#include "TopicRegistry.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every quiz question of a course, built at startup and again when the corpus changes.
+// Besides the questions written in <topic>_quiz.txt, each topic gets questions generated
+// from its own text:
+//   EASY    fill in the blank on a sentence of the Definition section
+//   MEDIUM  the complexity of an operation from a "- operation: O(...)" line
+//   HARD    the missing line of a Pseudocode section
+// Acceptable answers are reduced to words once here, so checking an answer is a whole-word
+// search, and a quiz is a window of pointers into the bank: starting one reads no file and
+// copies no question.
+class QuizBank {
+public:
+    struct Question {
+        std::string q;
+        std::string a;                  // as shown after a wrong answer
+        std::vector<std::string> keys;  // each acceptable answer as words(): "o(n)", "linear"
+        bool generated;
+    };
+    using Quiz = std::vector<const Question *>;
+
+    static const size_t kQuizLength = 5;
+    static const size_t kMinPartial = 4;  // shortest part of an authored answer that counts
+
+    ~QuizBank() { waitUntilBuilt(); }  // a background build still writes the members
+
+    // Run build (which ends by calling build()) on a background thread; the queries wait for it
+    void buildInBackground(std::function<void()> build);
+    void waitUntilBuilt() const;
+    // Questions of every registered topic: topicsDir/<topic>_quiz.txt plus the generated ones.
+    // content returns a topic's text. Returns the number of questions generated.
+    size_t build(const TopicRegistry &topics, const std::filesystem::path &topicsDir,
+                 const std::function<std::string(const std::string &)> &content);
+
+    // Up to kQuizLength questions, the variant-th window of the topic's pool for the difficulty
+    // (authored questions first), so successive quizzes move on through the pool.
+    // A topic without questions gets a few generic ones.
+    Quiz quiz(const std::string &topic, const std::string &difficulty, uint32_t variant) const;
+    // A fresh variant for each quiz started, shared by every conversation
+    uint32_t nextVariant() const { return variants_.fetch_add(1, std::memory_order_relaxed); }
+    size_t poolSize(const std::string &topic, const std::string &difficulty) const;  // 0: generic quiz
+
+    // Whether answer gives one of q's keys: the key itself, spacing and case aside, or the key
+    // as whole words of a longer answer ("it is o(n)"), a word or its plural counting as the
+    // same ("queues" for "queue"). An authored answer may also be given in
+    // part, whole words and at least kMinPartial characters ("step by step" for "step by step
+    // procedure"); a generated one may not, so "n" or "line" never pass for "O(n), linear".
+    static bool accepts(const Question &q, const std::string &answer);
+
+    // Lowercase, whitespace removed
+    static std::string normalize(const std::string &s);
+    // Lowercase words separated by single spaces, without surrounding punctuation
+    static std::string words(const std::string &s);
+
+private:
+    using Pool = std::vector<Question>;  // one per difficulty, indexed as LearningAnalytics
+
+    std::unordered_map<std::string, std::array<Pool, 3>> pools_;  // topic -> pools
+    Pool generic_;
+    std::shared_future<void> building_;
+    mutable std::atomic<uint32_t> variants_{0};
+
+    const Pool *pool(const std::string &topic, const std::string &difficulty) const;
+    static void loadAuthored(const std::filesystem::path &path, std::array<Pool, 3> &pools);
+    static void generate(const TopicRegistry::Topic &topic, const std::string &text, std::array<Pool, 3> &pools);
+};
@@ -1,288 +1,244 @@
-#include "QuizEngine.h"
-#include <iostream>
-#include <vector>
-#include <string>
-#include <algorithm>
-#include <fstream>
-#include <sstream>
-#include <ctime>
-#ifdef _WIN32
-#include <windows.h>
-#endif
-#include <set>
-
-bool QuizEngine::testMode = false;
-
-QuizEngine::QuizEngine(const std::string &dataBasePath) : dataBasePath_(dataBasePath) {}
-
-static std::string normalize(const std::string &s) {
-    std::string r;
-    for (char c : s) if (!isspace((unsigned char)c)) r += std::tolower((unsigned char)c);
-    return r;
-}
-
-static void setColor(int colorCode) {
-#ifdef _WIN32
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(h, colorCode);
-#endif
-}
-
-static void resetColor() {
-#ifdef _WIN32
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(h, 7); // Default white
-#endif
-}
-
-std::string QuizEngine::selectDifficulty() {
-    if (testMode) {
-        // In test mode, read difficulty from stdin without prompts
-        std::string choice;
-        std::getline(std::cin, choice);
-        if (choice == "1" || choice == "easy") return "EASY";
-        if (choice == "2" || choice == "medium") return "MEDIUM";
-        if (choice == "3" || choice == "hard") return "HARD";
-        return "EASY";  // default silently
-    }
-    
-    std::cout << "\n";
-    setColor(14); // Yellow
-    std::cout << "Select difficulty level:\n";
-    std::cout << "1. EASY (basic questions)\n";
-    std::cout << "2. MEDIUM (Intermediate complexity)\n";
-    std::cout << "3. HARD (Advanced questions)\n";
-    resetColor();
-    std::cout << "Enter choice (1-3): ";
-    
-    std::string choice;
-    std::getline(std::cin, choice);
-    
-    if (choice == "1" || choice == "easy") return "EASY";
-    if (choice == "2" || choice == "medium") return "MEDIUM";
-    if (choice == "3" || choice == "hard") return "HARD";
-    
-    std::cout << "Invalid choice. Defaulting to EASY.\n";
-    return "EASY";
-}
-
-QuizEngine::QuizResult QuizEngine::runQuizByDifficulty(const std::string &topic, const std::string &difficulty) {
-    struct QA { std::string q; std::string a; };
-    std::vector<QA> qa;
-    bool inDifficultySection = false;
-    
-    // Load quiz file
-    std::string path = dataBasePath_ + "\\topics\\" + topic + "_quiz.txt";
-    std::ifstream in(path);
-    
-    if (in) {
-        std::string line;
-        std::string curQ, curA;
-        
-        while (std::getline(in, line)) {
-            // Trim CR
-            if (!line.empty() && line.back() == '\r')
-                line.pop_back();
-            
-            // Check for difficulty markers
-            if (line == "[EASY]") {
-                inDifficultySection = (difficulty == "EASY");
-                continue;
-            } else if (line == "[MEDIUM]") {
-                inDifficultySection = (difficulty == "MEDIUM");
-                continue;
-            } else if (line == "[HARD]") {
-                inDifficultySection = (difficulty == "HARD");
-                continue;
-            }
-            
-            if (!inDifficultySection) continue;
-            
-            if (line.empty()) continue;
-            
-            if (line.rfind("Q:", 0) == 0) {
-                curQ = line.substr(2);
-            } else if (line.rfind("A:", 0) == 0) {
-                curA = line.substr(2);
-                if (!curQ.empty()) {
-                    qa.push_back({curQ, curA});
-                    curQ.clear(); curA.clear();
-                }
-            }
-        }
-        in.close();
-    }
-    
-    if (qa.empty()) {
-        std::cout << "No quiz found. Loading default questions...\n";
-        qa = {
-            {"What is a data structure?", "a way to organize data"},
-            {"Name a linear data structure.", "array"},
-            {"What does LIFO stand for?", "last in first out"},
-            {"What does FIFO stand for?", "first in first out"},
-            {"Define algorithm", "step by step procedure"}
-        };
-    }
-    
-    // Limit to 5 questions
-    if (qa.size() > 5) qa.resize(5);
-    
-    int correct = 0;
-    setColor(11); // Cyan
-    std::cout << "\n========== " << difficulty << " Quiz on " << topic << " ==========\n";
-    resetColor();
-    
-    for (size_t i = 0; i < qa.size(); ++i) {
-        setColor(10); // Green
-        std::cout << "\nQ" << (i+1) << ": ";
-        resetColor();
-        std::cout << qa[i].q << "\n> ";
-        
-        std::string ans;
-        std::getline(std::cin, ans);
-        
-        // Normalize and check answer (flexible matching)
-        std::string normalizedAns = normalize(ans);
-        std::string normalizedCorrect = normalize(qa[i].a);
-        // User wants to exit the quiz early
-        std::string low = normalizedAns;
-        if (low == "exit" || low == "quit" || low == "end" || low == "finish" ||
-            low == "end session" || low == "stop") {
-
-            setColor(14); // Yellow
-            std::cout << "\nExiting quiz early...\n";
-            resetColor();
-            break; // immediately stop the quiz loop
-        }
-        if (normalizedAns.find(normalizedCorrect) != std::string::npos || 
-            normalizedCorrect.find(normalizedAns) != std::string::npos) {
-            setColor(2); // Green
-            std::cout << " Correct!\n";
-            resetColor();
-            ++correct;
-        } else {
-            setColor(4); // Red
-            std::cout << " Wrong! ";
-            resetColor();
-            std::cout << "\nCorrect answer: " << qa[i].a << "\n";
-        }
-    }
-    
-    setColor(11); // Cyan
-    std::cout << "\n===================================\n";
-    std::cout << "Quiz Score: " << correct << " / " << qa.size() << "\n";
-    resetColor();
-    
-    return {topic, difficulty, correct, (int)qa.size()};
-}
-
-void QuizEngine::runQuiz(const std::string &topic) {
-    std::string difficulty = selectDifficulty();
-    QuizResult result = runQuizByDifficulty(topic, difficulty);
-    
-    // Ask to save progress
-    std::cout << "\nWould you like to save your progress?  ";
-    std::string saveChoice;
-    std::getline(std::cin, saveChoice);
-    
-    if (saveChoice == "yes" || saveChoice == "y" || saveChoice == "sure" || saveChoice == "yep") {
-        std::cout << "Enter your username: ";
-        std::string username;
-        std::getline(std::cin, username);
-        saveProgress(username, result);
-    }
-}
-
-void QuizEngine::saveProgress(const std::string &username, const QuizResult &result) {
-    std::string userPath = dataBasePath_ + "\\user\\quiz_progress.txt";
-
-    std::ofstream outFile(userPath, std::ios::app);
-    if (!outFile) {
-        std::cout << "Unable to open progress file for writing: " << userPath << "\n";
-        return;
-    }
-
-    // Write one entry per line. Appending preserves history and does not remove older records.
-    // Format: username|topic:score/total:difficulty
-    outFile << username << "|" << result.topic << ":" << result.score << "/" << result.total << ":" << result.difficulty << "\n";
-    outFile.close();
-
-    setColor(2); // Green
-    std::cout << "Progress saved successfully!\n";
-    resetColor();
-}
-
-void QuizEngine::displayProgress(const std::string &username) const {
-    std::string userPath = dataBasePath_ + "\\user\\quiz_progress.txt";
-    std::ifstream inFile(userPath);
-
-    if (!inFile) {
-        std::cout << "No progress file found.\n";
-        return;
-    }
-
-    std::string line;
-    int entryNum = 0;
-    setColor(11); // Cyan
-    std::cout << "\n========== Progress for " << username << " ==========" << "\n";
-    resetColor();
-
-    while (std::getline(inFile, line)) {
-        if (line.rfind(username + "|", 0) == 0) {
-            // parse right side: topic:score/total:difficulty
-            size_t pipePos = line.find('|');
-            if (pipePos == std::string::npos) continue;
-            std::string right = line.substr(pipePos + 1);
-            std::istringstream qss(right);
-            std::string topic, scoreStr, difficulty;
-            std::getline(qss, topic, ':');
-            std::getline(qss, scoreStr, ':');
-            std::getline(qss, difficulty, ':');
-
-            entryNum++;
-            setColor(10); // Green
-            std::cout << "Entry " << entryNum << ": ";
-            resetColor();
-            std::cout << topic << " (" << difficulty << ") - Score: " << scoreStr << "\n";
-        }
-    }
-
-    if (entryNum == 0) {
-        std::cout << "No progress found for user: " << username << "\n";
-    } else {
-        setColor(11); // Cyan
-        std::cout << "=====================================\n";
-        resetColor();
-    }
-    inFile.close();
-
-    // Now show topics/sessions from topics_history.txt
-    std::string topicsPath = dataBasePath_ + "\\user\\topics_history.txt";
-    std::ifstream tFile(topicsPath);
-    if (tFile) {
-        std::set<std::string> studied;
-        while (std::getline(tFile, line)) {
-            if (line.rfind(username + "|sessions:", 0) == 0) {
-                size_t pos = line.find('|');
-                if (pos == std::string::npos) continue;
-                std::string right = line.substr(pos + 1);
-                // right starts with sessions:
-                size_t colon = right.find(':');
-                if (colon == std::string::npos) continue;
-                std::string list = right.substr(colon + 1);
-                std::istringstream lss(list);
-                std::string topic;
-                while (std::getline(lss, topic, ',')) {
-                    if (!topic.empty()) studied.insert(topic);
-                }
-            }
-        }
-        if (!studied.empty()) {
-            setColor(11); // Cyan
-            std::cout << "\nTopics studied by " << username << ":\n";
-            resetColor();
-            for (auto &t : studied) std::cout << " - " << t << "\n";
-        }
-        tFile.close();
-    }
-}
+#include "QuizEngine.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <sstream>
+#include <ctime>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+bool QuizEngine::testMode = false;
+
+QuizEngine::QuizEngine(std::function<std::shared_ptr<const QuizBank>()> bank, LearningAnalytics &analytics,
+                       ProgressStore &progress, std::ostream &out)
+    : bank_(std::move(bank)), analytics_(analytics), progress_(progress), out_(out) {}
+
+static void setColor(int colorCode) {
+#ifdef _WIN32
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    SetConsoleTextAttribute(h, colorCode);
+#endif
+}
+
+static void resetColor() {
+#ifdef _WIN32
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    SetConsoleTextAttribute(h, 7); // Default white
+#endif
+}
+
+void QuizEngine::onMessage(const std::string &line) {
+    if (!pending_) return;
+    // The continuation may register the next one, so take it out first
+    auto next = std::move(pending_);
+    pending_ = nullptr;
+    next(line);
+}
+
+void QuizEngine::selectDifficulty(std::function<void(const std::string &)> then) {
+    // In test mode, read difficulty without prompts
+    if (!testMode) {
+        out_ << "\n";
+        setColor(14); // Yellow
+        out_ << "Select difficulty level:\n";
+        out_ << "1. EASY (basic questions)\n";
+        out_ << "2. MEDIUM (Intermediate complexity)\n";
+        out_ << "3. HARD (Advanced questions)\n";
+        resetColor();
+        out_ << "Enter choice (1-3): ";
+    }
+
+    awaitReply([this, then](const std::string &choice) {
+        if (choice == "1" || choice == "easy") return then("EASY");
+        if (choice == "2" || choice == "medium") return then("MEDIUM");
+        if (choice == "3" || choice == "hard") return then("HARD");
+
+        if (!testMode) out_ << "Invalid choice. Defaulting to EASY.\n";  // test mode defaults silently
+        then("EASY");
+    });
+}
+
+void QuizEngine::setState(const QuizState &state) {
+    state_ = state;
+    if (checkpointHook_) checkpointHook_();
+}
+
+void QuizEngine::startQuestions(const QuizState &start) {
+    quizBank_ = bank_();
+    if (quizBank_->poolSize(start.topic, start.difficulty) == 0) out_ << "No quiz found. Loading default questions...\n";
+    questions_ = quizBank_->quiz(start.topic, start.difficulty, start.variant);
+
+    setColor(11); // Cyan
+    out_ << "\n========== " << start.difficulty << " Quiz on " << start.topic << " ==========\n";
+    resetColor();
+
+    QuizState state = start;
+    state.active = true;
+    state.index = std::max(0, state.index);
+    askQuestion(state);
+}
+
+void QuizEngine::askQuestion(const QuizState &state) {
+    if (state.index >= (int)questions_.size()) {
+        finishQuiz(state);
+        return;
+    }
+    setState(state);
+    setColor(10); // Green
+    out_ << "\nQ" << (state.index + 1) << ": ";
+    resetColor();
+    out_ << questions_[state.index]->q << "\n> ";
+
+    awaitReply([this](const std::string &ans) { checkAnswer(ans); });
+}
+
+void QuizEngine::checkAnswer(const std::string &ans) {
+    QuizState next = state_;
+    const QuizBank::Question &qa = *questions_[next.index];
+
+    std::string normalizedAns = QuizBank::normalize(ans);
+    // User wants to exit the quiz early
+    std::string low = normalizedAns;
+    if (low == "exit" || low == "quit" || low == "end" || low == "finish" ||
+        low == "end session" || low == "stop") {
+
+        setColor(14); // Yellow
+        out_ << "\nExiting quiz early...\n";
+        resetColor();
+        finishQuiz(next); // immediately stop the quiz
+        return;
+    }
+    if (QuizBank::accepts(qa, ans)) {  // whole words of an acceptable answer, see QuizBank::accepts
+        setColor(2); // Green
+        out_ << " Correct!\n";
+        resetColor();
+        ++next.score;
+    } else {
+        setColor(4); // Red
+        out_ << " Wrong! ";
+        resetColor();
+        out_ << "\nCorrect answer: " << qa.a << "\n";
+    }
+    ++next.index;
+    askQuestion(next);
+}
+
+void QuizEngine::finishQuiz(const QuizState &state) {
+    setState(QuizState());
+    
+    setColor(11); // Cyan
+    out_ << "\n===================================\n";
+    out_ << "Quiz Score: " << state.score << " / " << questions_.size() << "\n";
+    resetColor();
+    
+    offerSave({state.topic, state.difficulty, state.score, (int)questions_.size()});
+}
+
+void QuizEngine::runQuiz(const std::string &topic) {
+    selectDifficulty([this, topic](const std::string &difficulty) {
+        QuizState start;
+        start.topic = topic;
+        start.difficulty = difficulty;
+        start.variant = bank_()->nextVariant();
+        startQuestions(start);
+    });
+}
+
+void QuizEngine::resumeQuiz(const QuizState &state) {
+    startQuestions(state);
+}
+
+void QuizEngine::offerSave(const QuizResult &result) {
+    // Ask to save progress
+    out_ << "\nWould you like to save your progress?  ";
+    awaitReply([this, result](const std::string &saveChoice) {
+        if (saveChoice == "yes" || saveChoice == "y" || saveChoice == "sure" || saveChoice == "yep") {
+            out_ << "Enter your username: ";
+            awaitReply([this, result](const std::string &username) {
+                lastUsername_ = username;
+                saveProgress(username, result);
+            });
+        }
+    });
+}
+
+void QuizEngine::saveProgress(const std::string &username, const QuizResult &result) {
+    // One entry per line, appended: history is preserved and older records are never removed
+    if (!progress_.appendQuiz(username, result.topic, result.score, result.total, result.difficulty)) {
+        out_ << "Unable to open progress file for writing: " << progress_.quizPath().string() << "\n";
+        return;
+    }
+
+    setColor(2); // Green
+    out_ << "Progress saved successfully!\n";
+    resetColor();
+}
+
+void QuizEngine::displayProgress(const std::string &username) const {
+    LearningAnalytics::Summary stats;
+    if (!analytics_.getSummary(username, stats)) {
+        out_ << "No progress found for user: " << username << "\n";
+        return;
+    }
+
+    setColor(11); // Cyan
+    out_ << "\n========== Progress for " << username << " ==========" << "\n";
+    resetColor();
+
+    int entryNum = 0;
+    analytics_.forEachEntry(username, [&](const LearningAnalytics::Entry &e) {
+        entryNum++;
+        setColor(10); // Green
+        out_ << "Entry " << entryNum << ": ";
+        resetColor();
+        out_ << e.topic << " (" << e.difficulty << ") - Score: " << e.score << "/" << e.total << "\n";
+    });
+
+    if (entryNum == 0) {
+        out_ << "No quiz results found for user: " << username << "\n";
+    } else {
+        // Per-topic summary: attempts, mean and best score per difficulty
+        static const char *levels[] = {"EASY", "MEDIUM", "HARD"};
+        setColor(11); // Cyan
+        out_ << "\nSummary by topic:\n";
+        resetColor();
+        analytics_.forEachTopic(username, [&](const std::string &topic, const LearningAnalytics::TopicStats &t) {
+            out_ << " - " << topic << ": " << t.attempts << " attempt(s), mean " << (int)(t.meanPct() + 0.5) << "%";
+            for (int d = 0; d < 3; ++d) {
+                const auto &ds = t.byDifficulty[d];
+                if (ds.attempts == 0) continue;
+                out_ << " | " << levels[d] << " mean " << (int)(ds.meanPct() + 0.5)
+                     << "% best " << (int)(ds.bestPct + 0.5) << "%";
+            }
+            out_ << "\n";
+        });
+
+        out_ << "Overall mean: " << (int)(stats.meanPct + 0.5) << "%"
+             << "  (class percentile: " << (int)(analytics_.classPercentileRank(username) + 0.5)
+             << ", class median " << (int)(analytics_.classPercentile(50) + 0.5) << "%)\n";
+        out_ << "Pass streak: " << stats.currentStreak << " (best " << stats.bestStreak << ")\n";
+
+        auto weakest = analytics_.weakestTopics(username, 3);
+        if (!weakest.empty()) {
+            out_ << "Weakest topics:";
+            for (size_t i = 0; i < weakest.size(); ++i) {
+                out_ << (i ? ", " : " ") << weakest[i].first << " (" << (int)(weakest[i].second + 0.5) << "%)";
+            }
+            out_ << "\n";
+        }
+        setColor(11); // Cyan
+        out_ << "=====================================\n";
+        resetColor();
+    }
+
+    std::vector<std::string> studied;
+    analytics_.studiedTopics(username, studied);
+    if (!studied.empty()) {
+        setColor(11); // Cyan
+        out_ << "\nTopics studied by " << username << ":\n";
+        resetColor();
+        for (auto &t : studied) out_ << " - " << t << "\n";
+    }
+}
\ No newline at end of file
@@ -1,32 +1,79 @@
-#pragma once
-#include <string>
-
-class QuizEngine {
-public:
-    static bool testMode;  // flag to enable test/non-interactive mode
-    QuizEngine(const std::string &dataBasePath);
-    void runQuiz(const std::string &topic);
-    
-    // Structure to hold quiz result
-    struct QuizResult {
-        std::string topic;
-        std::string difficulty;
-        int score;
-        int total;
-    };
-    
-    // Save quiz result to user progress file
-    void saveProgress(const std::string &username, const QuizResult &result);
-    
-    // Display user progress from file
-    void displayProgress(const std::string &username) const;
-    
-private:
-    std::string dataBasePath_;
-    
-    // Helper to select difficulty level interactively
-    std::string selectDifficulty();
-    
-    // Helper to parse and run questions for specific difficulty
-    QuizResult runQuizByDifficulty(const std::string &topic, const std::string &difficulty);
+#pragma once
+#include "LearningAnalytics.h"
+#include "ProgressStore.h"
+#include "QuizBank.h"
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class QuizEngine {
+public:
+    static bool testMode;  // flag to enable test/non-interactive mode
+    // bank returns the course's current quiz bank, which a corpus change replaces
+    QuizEngine(std::function<std::shared_ptr<const QuizBank>()> bank, LearningAnalytics &analytics,
+               ProgressStore &progress, std::ostream &out = std::cout);
+    // Start a quiz. The quiz is driven by onMessage(): each prompt (difficulty, answers,
+    // save/username) waits for the next message instead of blocking on std::cin.
+    void runQuiz(const std::string &topic);
+    bool waiting() const { return (bool)pending_; }  // true while a prompt expects a reply
+    void onMessage(const std::string &line);
+    
+    // Progress of the quiz currently being taken, kept up to date after every answer
+    struct QuizState {
+        bool active = false;
+        std::string topic;
+        std::string difficulty;
+        int index = 0;  // next question to ask
+        int score = 0;  // correct answers so far
+        uint32_t variant = 0;  // which window of the topic's questions (QuizBank::quiz)
+    };
+    const QuizState &state() const { return state_; }
+    // Called whenever state() changes, so the session can be checkpointed mid-quiz
+    void setCheckpointHook(std::function<void()> hook) { checkpointHook_ = hook; }
+    // Continue an interrupted quiz (e.g. restored after a restart) at state.index
+    void resumeQuiz(const QuizState &state);
+    
+    // Structure to hold quiz result
+    struct QuizResult {
+        std::string topic;
+        std::string difficulty;
+        int score;
+        int total;
+    };
+    
+    // Save quiz result to user progress file
+    void saveProgress(const std::string &username, const QuizResult &result);
+    
+    // Username entered at the most recent save prompt (empty if none yet)
+    const std::string &lastUsername() const { return lastUsername_; }
+
+    // Display user progress from the in-memory analytics (no file rescans)
+    void displayProgress(const std::string &username) const;
+    
+private:
+    std::function<std::shared_ptr<const QuizBank>()> bank_;
+    LearningAnalytics &analytics_;
+    ProgressStore &progress_;  // where saved results go
+    std::ostream &out_;
+    std::string lastUsername_;
+    QuizState state_;
+    std::shared_ptr<const QuizBank> quizBank_;  // the bank the quiz in progress came from
+    QuizBank::Quiz questions_;  // questions of the quiz in progress, owned by quizBank_
+    std::function<void()> checkpointHook_;
+    std::function<void(const std::string &)> pending_;  // continuation for the next message
+    
+    // Helper to select difficulty level interactively; then() receives EASY/MEDIUM/HARD
+    void selectDifficulty(std::function<void(const std::string &)> then);
+    
+    void startQuestions(const QuizState &start);
+    void askQuestion(const QuizState &state);
+    void checkAnswer(const std::string &ans);
+    void finishQuiz(const QuizState &state);
+
+    // Ask whether to save the result and save it
+    void offerSave(const QuizResult &result);
+    void setState(const QuizState &state);
+    void awaitReply(std::function<void(const std::string &)> next) { pending_ = std::move(next); }
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "ResponseCache.h"
+#include <cctype>
+#include <functional>
+
+ResponseCache::ResponseCache(size_t capacity, size_t shards) {
+    if (shards == 0) shards = 1;
+    perShardCapacity_ = capacity / shards ? capacity / shards : 1;
+    for (size_t i = 0; i < shards; ++i) shards_.push_back(std::make_unique<Shard>());
+}
+
+ResponseCache::Shard &ResponseCache::shardFor(const std::string &key) {
+    return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+bool ResponseCache::find(const std::string &key, uint64_t version, Entry &out) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.index.find(key);
+    if (it == s.index.end()) return false;
+    if (it->second->version != version) {
+        // Built from an older corpus: drop it
+        s.lru.erase(it->second);
+        s.index.erase(it);
+        return false;
+    }
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    out = it->second->entry;
+    return true;
+}
+
+bool ResponseCache::get(const std::string &key, uint64_t version, Entry &out) {
+    bool hit = find(key, version, out);
+    (hit ? hits_ : misses_)++;
+    return hit;
+}
+
+bool ResponseCache::get(const std::string &key, const std::string &fallbackKey, uint64_t version, Entry &out) {
+    bool hit = find(key, version, out) || find(fallbackKey, version, out);
+    (hit ? hits_ : misses_)++;
+    return hit;
+}
+
+void ResponseCache::put(const std::string &key, uint64_t version, const Entry &entry) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.index.find(key);
+    if (it != s.index.end()) {
+        it->second->version = version;
+        it->second->entry = entry;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return;
+    }
+    s.lru.push_front({key, version, entry});
+    s.index[key] = s.lru.begin();
+    if (s.lru.size() > perShardCapacity_) {
+        s.index.erase(s.lru.back().key);
+        s.lru.pop_back();
+        evictions_++;
+    }
+}
+
+void ResponseCache::clear() {
+    for (auto &s : shards_) {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        s->lru.clear();
+        s->index.clear();
+    }
+}
+
+ResponseCache::Stats ResponseCache::stats() const {
+    size_t size = 0;
+    for (auto &s : shards_) {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        size += s->lru.size();
+    }
+    return {hits_.load(), misses_.load(), evictions_.load(), size};
+}
+
+std::string ResponseCache::normalizeInput(const std::string &input) {
+    std::string out;
+    bool space = false;
+    for (char c : input) {
+        unsigned char uc = (unsigned char)c;
+        if (std::isspace(uc)) {
+            space = !out.empty();
+            continue;
+        }
+        if (space) out += ' ';
+        space = false;
+        out += (char)std::tolower(uc);
+    }
+    while (!out.empty() && (out.back() == '?' || out.back() == '!' || out.back() == '.' || out.back() == ' ')) out.pop_back();
+    return out;
+}
+
+std::string ResponseCache::makeKey(const std::string &input, const std::string &contextTopic,
+                                   const std::string &course) {
+    return course + '\x1f' + normalizeInput(input) + '\x1f' + contextTopic;
+}
+
+ResponseCache &ResponseCache::shared() {
+    static ResponseCache cache;
+    return cache;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bounded, sharded LRU cache of deterministic chat responses.
+// Keyed by (normalized input, context topic). Each entry remembers the corpus
+// version it was built from, so a corpus change invalidates it on lookup.
+// Every shard has its own mutex, so one instance can be shared by worker threads.
+class ResponseCache {
+public:
+    struct Line {
+        std::string text;
+        int msDelay;
+    };
+
+    struct Entry {
+        std::string intent;  // intent that produced the reply
+        std::string topic;   // topic to make current when replaying ("unknown" if none)
+        std::vector<Line> lines;
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t size;
+    };
+
+    explicit ResponseCache(size_t capacity = 4096, size_t shards = 16);
+
+    bool get(const std::string &key, uint64_t version, Entry &out);
+    // Try key, then fallbackKey; counts as a single hit or miss
+    bool get(const std::string &key, const std::string &fallbackKey, uint64_t version, Entry &out);
+    void put(const std::string &key, uint64_t version, const Entry &entry);
+    void clear();
+    Stats stats() const;
+
+    // Lowercase, collapse whitespace and drop trailing punctuation before keying
+    static std::string normalizeInput(const std::string &input);
+    // Courses share the cache, so keys are scoped by course name as well
+    static std::string makeKey(const std::string &input, const std::string &contextTopic,
+                               const std::string &course = std::string());
+
+    // Process-wide instance shared by all conversations
+    static ResponseCache &shared();
+
+private:
+    struct Node {
+        std::string key;
+        uint64_t version;
+        Entry entry;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::list<Node> lru;  // front = most recently used
+        std::unordered_map<std::string, std::list<Node>::iterator> index;
+    };
+
+    size_t perShardCapacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+
+    Shard &shardFor(const std::string &key);
+    bool find(const std::string &key, uint64_t version, Entry &out);
+};
@@ -0,0 +1,736 @@
+#include "SessionStore.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kMagic[4] = {'D', 'S', 'A', 'S'};
+static const uint8_t kFormatVersion = 1;
+static const uint64_t kMaxVarint = 10;  // bytes of the longest uint64 varint
+
+bool SessionState::operator==(const SessionState &o) const {
+    return topicStack == o.topicStack && sessionTopics == o.sessionTopics && quizActive == o.quizActive &&
+           quizTopic == o.quizTopic && quizDifficulty == o.quizDifficulty && quizIndex == o.quizIndex &&
+           quizScore == o.quizScore && quizVariant == o.quizVariant && streamTopic == o.streamTopic &&
+           streamOffset == o.streamOffset;
+}
+
+static uint32_t fnv1a(const char *p, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void putVarint(std::string &out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char)((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+static bool getVarint(const char *&p, const char *end, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = (uint8_t)*p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static void putString(std::string &out, const std::string &s) {
+    putVarint(out, s.size());
+    out += s;
+}
+
+static bool getString(const char *&p, const char *end, std::string &s) {
+    uint64_t len;
+    if (!getVarint(p, end, len) || len > (uint64_t)(end - p)) return false;
+    s.assign(p, (size_t)len);
+    p += len;
+    return true;
+}
+
+static void putList(std::string &out, const std::vector<std::string> &v) {
+    putVarint(out, v.size());
+    for (auto &s : v) putString(out, s);
+}
+
+static bool getList(const char *&p, const char *end, std::vector<std::string> &v) {
+    uint64_t n;
+    if (!getVarint(p, end, n) || n > (uint64_t)(end - p)) return false;
+    v.resize((size_t)n);
+    for (auto &s : v) if (!getString(p, end, s)) return false;
+    return true;
+}
+
+uint16_t TopicInterner::intern(const std::string &name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    uint16_t id = (uint16_t)names_.size();
+    names_.push_back(name);
+    ids_[name] = id;
+    return id;
+}
+
+#ifdef _WIN32
+
+bool SessionStore::lockLog() {
+    if (!lockHandle_) {
+        HANDLE h = CreateFileA((path_ + ".lock").c_str(), GENERIC_READ | GENERIC_WRITE,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        lockHandle_ = h;
+    }
+    OVERLAPPED at{};
+    return LockFileEx((HANDLE)lockHandle_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &at) != 0;
+}
+
+void SessionStore::unlockLog() {
+    OVERLAPPED at{};
+    if (lockHandle_) UnlockFileEx((HANDLE)lockHandle_, 0, 1, 0, &at);
+}
+
+bool SessionStore::readLog(const std::string &path, uint64_t from, FileId &id, uint64_t &size, std::string &data,
+                           uint64_t maxBytes) {
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(h, &info) != 0;
+    if (ok) {
+        id.volume = info.dwVolumeSerialNumber;
+        id.index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+        size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+        data.assign(size > from ? (size_t)std::min(size - from, maxBytes) : 0, '\0');
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)from;
+        size_t got = 0;
+        if (!data.empty() && SetFilePointerEx(h, pos, nullptr, FILE_BEGIN)) {
+            DWORD n = 0;
+            while (got < data.size() && ReadFile(h, &data[got], (DWORD)std::min<size_t>(data.size() - got, 1u << 30), &n, nullptr) && n > 0) {
+                got += n;
+            }
+        }
+        data.resize(got);
+    }
+    CloseHandle(h);
+    return ok;
+}
+
+bool SessionStore::appendLog(const std::string &path, const std::string &records) {
+    HANDLE h = CreateFileA(path.c_str(), FILE_READ_DATA | FILE_APPEND_DATA | SYNCHRONIZE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(h, &size) != 0;
+    std::string data;
+    if (ok && size.QuadPart == 0) {
+        data.assign(kMagic, 4);
+        data += (char)kFormatVersion;
+    }
+    data += records;
+    DWORD written = 0;
+    ok = ok && WriteFile(h, data.data(), (DWORD)data.size(), &written, nullptr) && written == data.size();
+    CloseHandle(h);
+    return ok;
+}
+
+#else
+
+bool SessionStore::lockLog() {
+    if (lockFd_ < 0) {
+        lockFd_ = ::open((path_ + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lockFd_ < 0) return false;
+    }
+    while (flock(lockFd_, LOCK_EX) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return true;
+}
+
+void SessionStore::unlockLog() {
+    if (lockFd_ >= 0) flock(lockFd_, LOCK_UN);
+}
+
+bool SessionStore::readLog(const std::string &path, uint64_t from, FileId &id, uint64_t &size, std::string &data,
+                           uint64_t maxBytes) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok) {
+        id.volume = (uint64_t)st.st_dev;
+        id.index = (uint64_t)st.st_ino;
+        size = (uint64_t)st.st_size;
+        data.assign(size > from ? (size_t)std::min(size - from, maxBytes) : 0, '\0');
+        size_t got = 0;
+        while (got < data.size()) {
+            ssize_t n = pread(fd, &data[got], data.size() - got, (off_t)(from + got));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            got += (size_t)n;
+        }
+        data.resize(got);
+    }
+    ::close(fd);
+    return ok;
+}
+
+bool SessionStore::appendLog(const std::string &path, const std::string &records) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    std::string data;
+    if (ok && st.st_size == 0) {
+        data.assign(kMagic, 4);
+        data += (char)kFormatVersion;
+    }
+    data += records;
+    const char *p = data.data();
+    size_t left = data.size();
+    while (ok && left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    ::close(fd);
+    return ok;
+}
+
+#endif
+
+SessionStore::SessionStore(const std::string &path) : path_(path) {}
+
+SessionStore::~SessionStore() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+#ifdef _WIN32
+    if (lockHandle_) CloseHandle((HANDLE)lockHandle_);
+#else
+    if (lockFd_ >= 0) ::close(lockFd_);
+#endif
+}
+
+std::string SessionStore::uniqueId(const std::string &prefix) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    std::random_device rd;
+    char nonce[9];
+    std::snprintf(nonce, sizeof(nonce), "%08x", (unsigned)rd());
+    return prefix + "-" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(now).count()) + "-" +
+           std::to_string(pid) + "-" + nonce;
+}
+
+bool SessionStore::validName(const std::string &name) {
+    if (name.empty() || name.size() > 64) return false;
+    for (char ch : name) {
+        if (!std::isalnum((unsigned char)ch) && ch != '_' && ch != '-') return false;
+    }
+    return true;
+}
+
+void SessionStore::startWriter() {
+    if (writer_.joinable()) return;
+    writer_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        while (!stop_) {
+            wake_.wait_for(lock, kWriteInterval, [this]() { return stop_; });
+            lock.unlock();
+            checkpoint();  // also the last one, once stop_ is set
+            lock.lock();
+        }
+    });
+}
+
+// Payload: id | flags (1 = removed, 2 = quiz active, 4 = streaming) | stack | topics
+//          | [quiz topic, difficulty, index, score, variant] | [stream topic, offset]
+// (snapshots written before quiz variants end after the score)
+void SessionStore::encode(std::string &out, const std::string &id, const SessionState &s, bool removed) {
+    std::string payload;
+    putString(payload, id);
+    bool streaming = !s.streamTopic.empty();
+    payload += (char)((removed ? 1 : 0) | (s.quizActive ? 2 : 0) | (streaming ? 4 : 0));
+    if (!removed) {
+        putList(payload, s.topicStack);
+        putList(payload, s.sessionTopics);
+        if (s.quizActive) {
+            putString(payload, s.quizTopic);
+            putString(payload, s.quizDifficulty);
+            putVarint(payload, s.quizIndex);
+            putVarint(payload, s.quizScore);
+            putVarint(payload, s.quizVariant);
+        }
+        if (streaming) {
+            putString(payload, s.streamTopic);
+            putVarint(payload, s.streamOffset);
+        }
+    }
+    putVarint(out, payload.size());
+    out += payload;
+    uint32_t sum = fnv1a(payload.data(), payload.size());
+    for (int i = 0; i < 4; ++i) out += (char)((sum >> (8 * i)) & 0xff);
+}
+
+bool SessionStore::decode(const char *p, size_t len, std::string &id, SessionState &s, bool &removed) {
+    const char *end = p + len;
+    if (!getString(p, end, id) || p >= end) return false;
+    uint8_t flags = (uint8_t)*p++;
+    s = SessionState();
+    removed = flags & 1;
+    if (removed) return true;
+    if (!getList(p, end, s.topicStack) || !getList(p, end, s.sessionTopics)) return false;
+    s.quizActive = flags & 2;
+    if (s.quizActive) {
+        uint64_t index, score;
+        if (!getString(p, end, s.quizTopic) || !getString(p, end, s.quizDifficulty) ||
+            !getVarint(p, end, index) || !getVarint(p, end, score)) return false;
+        s.quizIndex = (uint32_t)index;
+        s.quizScore = (uint32_t)score;
+        uint64_t variant = 0;
+        if (p < end && !getVarint(p, end, variant)) return false;
+        s.quizVariant = (uint32_t)variant;
+    }
+    if (flags & 4) {
+        uint64_t offset;
+        if (!getString(p, end, s.streamTopic) || !getVarint(p, end, offset)) return false;
+        s.streamOffset = (uint32_t)offset;
+    }
+    return p == end;
+}
+
+void SessionStore::setLimits(size_t maxHot, size_t maxHotBytes, std::chrono::seconds idleTimeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxHot_ = maxHot ? maxHot : 1;
+    maxHotBytes_ = maxHotBytes;
+    idleTimeout_ = idleTimeout;
+}
+
+SessionStore::CompactSession SessionStore::compact(const SessionState &state) {
+    CompactSession c;
+    size_t skip = state.topicStack.size() > (size_t)CompactSession::kStack
+                      ? state.topicStack.size() - CompactSession::kStack : 0;
+    for (size_t i = skip; i < state.topicStack.size(); ++i) c.stack[c.stackLen++] = names_.intern(state.topicStack[i]);
+    for (auto &t : state.sessionTopics) {
+        uint16_t id = names_.intern(t);
+        if (c.topicsLen < CompactSession::kTopics) c.topics[c.topicsLen++] = id;
+        else c.moreTopics.push_back(id);
+    }
+    c.quizActive = state.quizActive;
+    if (state.quizActive) {
+        c.quizTopic = names_.intern(state.quizTopic);
+        c.quizDifficulty = names_.intern(state.quizDifficulty);
+        c.quizIndex = state.quizIndex;
+        c.quizScore = state.quizScore;
+        c.quizVariant = state.quizVariant;
+    }
+    c.streaming = !state.streamTopic.empty();
+    if (c.streaming) {
+        c.streamTopic = names_.intern(state.streamTopic);
+        c.streamOffset = state.streamOffset;
+    }
+    return c;
+}
+
+SessionState SessionStore::expand(const CompactSession &c) const {
+    SessionState state;
+    for (int i = 0; i < c.stackLen; ++i) state.topicStack.push_back(names_.name(c.stack[i]));
+    for (int i = 0; i < c.topicsLen; ++i) state.sessionTopics.push_back(names_.name(c.topics[i]));
+    for (uint16_t id : c.moreTopics) state.sessionTopics.push_back(names_.name(id));
+    state.quizActive = c.quizActive;
+    if (c.quizActive) {
+        state.quizTopic = names_.name(c.quizTopic);
+        state.quizDifficulty = names_.name(c.quizDifficulty);
+        state.quizIndex = c.quizIndex;
+        state.quizScore = c.quizScore;
+        state.quizVariant = c.quizVariant;
+    }
+    if (c.streaming) {
+        state.streamTopic = names_.name(c.streamTopic);
+        state.streamOffset = c.streamOffset;
+    }
+    return state;
+}
+
+// Approximate footprint: slot, key (in the map and the LRU list), overflow buffer, node overheads
+size_t SessionStore::bytesOf(const std::string &id, const Slot &slot) {
+    return sizeof(Slot) + 2 * (sizeof(std::string) + id.capacity()) +
+           slot.session.moreTopics.capacity() * sizeof(uint16_t) + 64;
+}
+
+SessionStore::Slot &SessionStore::touchLocked(const std::string &id) {
+    auto it = hot_.find(id);
+    if (it == hot_.end()) {
+        it = hot_.emplace(id, Slot()).first;
+        lru_.push_front(id);
+        it->second.lru = lru_.begin();
+        hotBytes_ += bytesOf(id, it->second);
+    } else {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+    }
+    it->second.lastTouch = std::chrono::steady_clock::now();
+    return it->second;
+}
+
+void SessionStore::dropHotLocked(std::unordered_map<std::string, Slot>::iterator it) {
+    hotBytes_ -= std::min(hotBytes_, bytesOf(it->first, it->second));
+    lru_.erase(it->second.lru);
+    hot_.erase(it);
+}
+
+bool SessionStore::hotLocked(const std::string &id, SessionState &out, bool &found) {
+    auto it = hot_.find(id);
+    if (it == hot_.end()) return false;
+    touchLocked(id);
+    found = !it->second.removed;
+    if (found) out = expand(it->second.session);
+    return true;
+}
+
+void SessionStore::update(const std::string &sessionId, const SessionState &state) {
+    // Unchanged sessions are not written again; a cold one is faulted in to compare
+    SessionState stored;
+    bool unchanged = find(sessionId, stored) && stored == state;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unchanged) {
+        if (hot_.count(sessionId)) touchLocked(sessionId);
+        return;
+    }
+    Slot &slot = touchLocked(sessionId);
+    hotBytes_ -= std::min(hotBytes_, bytesOf(sessionId, slot));
+    slot.session = compact(state);
+    hotBytes_ += bytesOf(sessionId, slot);
+    slot.removed = false;
+    slot.dirty = true;
+    slot.version++;
+}
+
+void SessionStore::remove(const std::string &sessionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hot_.count(sessionId) && !offsets_.count(sessionId)) return;
+    // Keep a tombstone in memory until the next checkpoint writes it
+    Slot &slot = touchLocked(sessionId);
+    slot.session = CompactSession();
+    slot.removed = true;
+    slot.dirty = true;
+    slot.version++;
+}
+
+bool SessionStore::find(const std::string &sessionId, SessionState &out) {
+    bool found = false;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        uint64_t offset;
+        FileId log;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (hotLocked(sessionId, out, found)) return found;
+            syncIndexLocked();  // another process may have saved it since
+            auto off = offsets_.find(sessionId);
+            if (off == offsets_.end()) return false;
+            offset = off->second;
+            log = logId_;
+        }
+        // Cold: the record is read without mutex_, so other sessions' turns go on meanwhile
+        std::string recId;
+        SessionState state;
+        bool removed = false;
+        bool read = readRecord(log, offset, recId, state, removed);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (hotLocked(sessionId, out, found)) return found;  // faulted in or updated meanwhile
+        auto off = offsets_.find(sessionId);
+        // The log was replaced, or the session saved again, since the offset was taken: look again
+        if (!read || off == offsets_.end() || off->second != offset || logId_ != log) continue;
+        if (removed || recId != sessionId) return false;
+        Slot &slot = touchLocked(sessionId);
+        hotBytes_ -= std::min(hotBytes_, bytesOf(sessionId, slot));
+        slot.session = compact(state);
+        hotBytes_ += bytesOf(sessionId, slot);
+        faults_++;
+        out = std::move(state);
+        return true;
+    }
+    return false;
+}
+
+size_t SessionStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = offsets_.size();
+    for (auto &kv : hot_) {
+        bool onDisk = offsets_.count(kv.first) > 0;
+        if (kv.second.removed && onDisk) --n;
+        else if (!kv.second.removed && !onDisk) ++n;
+    }
+    return n;
+}
+
+SessionStore::Stats SessionStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t cold = 0;
+    for (auto &kv : offsets_) if (!hot_.count(kv.first)) ++cold;
+    return {hot_.size(), cold, hotBytes_, evictions_, faults_};
+}
+
+size_t SessionStore::checkpoint() {
+    std::lock_guard<std::mutex> checkpointing(checkpointMutex_);
+    struct Written {
+        std::string id;
+        uint64_t version;
+    };
+    std::vector<Written> written;
+    std::string buf;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &kv : hot_) {
+            if (!kv.second.dirty) continue;
+            written.push_back({kv.first, kv.second.version});
+            encode(buf, kv.first, expand(kv.second.session), kv.second.removed);
+        }
+        if (written.empty()) {
+            syncIndexLocked();  // drops sessions other processes have changed since
+            evictLocked(std::chrono::steady_clock::now());
+            return 0;
+        }
+    }
+
+    if (!lockLog()) return 0;
+    bool repaired = false;
+    {
+        // Under the lock nobody is mid-append, so a torn tail is left by a crash and would hide our records
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!syncIndexLocked()) {
+            // Compaction writes every hot session as it is now, so buf is both written and out of
+            // date; if it fails the sessions stay dirty for the next checkpoint
+            if (!compactLocked()) {
+                unlockLog();
+                return 0;
+            }
+            repaired = true;
+        }
+    }
+    // Sessions keep changing while the records go to disk; only this thread appends
+    bool ok = repaired || appendLog(path_, buf);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ok && !repaired) {
+        // Offsets come from the file itself: ours, plus anything appended before them
+        syncIndexLocked();
+        for (auto &w : written) {
+            auto it = hot_.find(w.id);
+            if (it == hot_.end() || it->second.version != w.version) continue;  // changed again: stays dirty
+            if (it->second.removed) dropHotLocked(it);  // tombstones only need to reach the file once
+            else it->second.dirty = false;
+        }
+    }
+    evictLocked(std::chrono::steady_clock::now());
+
+    // Keep the log from growing without bound
+    if (logRecords_ > 1024 && logRecords_ > 4 * offsets_.size()) compactLocked();
+    unlockLog();
+    return ok ? written.size() : 0;
+}
+
+bool SessionStore::syncIndexLocked() {
+    FileId id;
+    uint64_t size = 0;
+    std::string data;
+    if (!readLog(path_, logEnd_, id, size, data)) return true;  // not created yet
+    bool replaced = id != logId_ || size < logEnd_;
+    if (replaced) {
+        // Compacted by another process: offsets into the old file mean nothing now
+        offsets_.clear();
+        logId_ = id;
+        logEnd_ = 0;
+        logRecords_ = 0;
+        if (!readLog(path_, 0, id, size, data) || id != logId_) return true;  // replaced again; next time
+    }
+    if (data.empty()) return true;
+
+    const char *base = data.data();  // file offset logEnd_
+    const char *p = base;
+    const char *end = base + data.size();
+    if (logEnd_ == 0) {
+        if (data.size() < 5) return false;
+        if (data.compare(0, 4, kMagic, 4) != 0 || (uint8_t)data[4] != kFormatVersion) return false;
+        p += 5;
+    }
+    bool torn = false;
+    while (p < end) {
+        const char *rec = p;
+        uint64_t len;
+        if (!getVarint(p, end, len) || len + 4 > (uint64_t)(end - p)) { torn = true; p = rec; break; }
+        const char *payload = p;
+        p += len;
+        uint32_t sum = 0;
+        for (int i = 0; i < 4; ++i) sum |= (uint32_t)(uint8_t)p[i] << (8 * i);
+        p += 4;
+        std::string recId;
+        const char *q = payload;
+        if (sum != fnv1a(payload, (size_t)len) || !getString(q, payload + len, recId) || q >= payload + len) {
+            torn = true;
+            p = rec;
+            break;
+        }
+        ++logRecords_;
+        if ((uint8_t)*q & 1) offsets_.erase(recId);
+        else offsets_[recId] = logEnd_ + (uint64_t)(rec - base);
+        // A newer record than the one a clean hot copy came from: fault it in again when needed
+        if (!replaced) {
+            auto it = hot_.find(recId);
+            if (it != hot_.end() && !it->second.dirty) dropHotLocked(it);
+        }
+    }
+    logEnd_ += (uint64_t)(p - base);
+    return !torn;
+}
+
+// Move clean sessions to the cold tier, starting from the least recently used:
+// idle ones always, others only while the hot tier is over its caps.
+void SessionStore::evictLocked(std::chrono::steady_clock::time_point now) {
+    auto it = lru_.end();
+    while (it != lru_.begin()) {
+        --it;
+        auto slot = hot_.find(*it);
+        bool overCap = hot_.size() > maxHot_ || hotBytes_ > maxHotBytes_;
+        bool idle = now - slot->second.lastTouch >= idleTimeout_;
+        if (!overCap && !idle) break;  // everything further forward was touched more recently
+        if (slot->second.dirty) continue;  // not on disk yet; evicted after the next checkpoint
+        auto next = std::next(it);
+        dropHotLocked(slot);
+        evictions_++;
+        it = next;
+    }
+}
+
+size_t SessionStore::restore() {
+    std::lock_guard<std::mutex> checkpointing(checkpointMutex_);
+    bool locked = lockLog();
+    std::lock_guard<std::mutex> lock(mutex_);
+    hot_.clear();
+    lru_.clear();
+    offsets_.clear();
+    hotBytes_ = 0;
+    logId_ = FileId();
+    logEnd_ = 0;
+    logRecords_ = 0;
+
+    // Index only: remember where each session's latest record lives.
+    // Rewrite if the tail was torn (later appends would sit behind it) or the log is mostly stale.
+    bool clean = syncIndexLocked();
+    if (locked && (!clean || logRecords_ > 2 * offsets_.size() + 64)) compactLocked();
+    if (locked) unlockLog();
+    return offsets_.size();
+}
+
+bool SessionStore::readRecord(const FileId &log, uint64_t offset, std::string &id, SessionState &state,
+                              bool &removed) const {
+    // The length is only trusted once the record is known to fit in that file
+    FileId fileId;
+    uint64_t size = 0;
+    std::string head;
+    if (!readLog(path_, offset, fileId, size, head, kMaxVarint) || fileId != log) return false;
+    const char *p = head.data();
+    uint64_t len = 0;
+    if (!getVarint(p, head.data() + head.size(), len)) return false;
+    uint64_t start = offset + (uint64_t)(p - head.data());
+    if (len > size || start + len + 4 > size) return false;
+    std::string payload;
+    if (!readLog(path_, start, fileId, size, payload, len + 4) || fileId != log || payload.size() != len + 4)
+        return false;
+    uint32_t sum = 0;
+    for (int i = 0; i < 4; ++i) sum |= (uint32_t)(uint8_t)payload[len + i] << (8 * i);
+    if (sum != fnv1a(payload.data(), (size_t)len)) return false;
+    return decode(payload.data(), (size_t)len, id, state, removed);
+}
+
+// Rewrite the log with one record per live session (hot ones from memory, cold ones from the old log)
+bool SessionStore::compactLocked() {
+    std::string buf(kMagic, 4);
+    buf += (char)kFormatVersion;
+    std::unordered_map<std::string, uint64_t> newOffsets;
+
+    // Cold sessions are copied from the old log, read in one go; the caller has just indexed it
+    std::string old;
+    FileId id;
+    uint64_t size = 0;
+    if (readLog(path_, 0, id, size, old) && id != logId_) return false;  // not the file offsets_ describes
+    for (auto &kv : offsets_) {
+        if (hot_.count(kv.first) || kv.second >= old.size()) continue;
+        const char *p = old.data() + kv.second;
+        const char *end = old.data() + old.size();
+        uint64_t len;
+        if (!getVarint(p, end, len) || len + 4 > (uint64_t)(end - p)) continue;
+        size_t recLen = (size_t)(p - (old.data() + kv.second)) + (size_t)len + 4;
+        newOffsets[kv.first] = buf.size();
+        buf.append(old, (size_t)kv.second, recLen);
+    }
+    for (auto &kv : hot_) {
+        if (kv.second.removed) continue;
+        newOffsets[kv.first] = buf.size();
+        encode(buf, kv.first, expand(kv.second.session), false);
+    }
+
+    std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(buf.data(), (std::streamsize)buf.size());
+        if (!out) return false;
+    }
+    // Replace, never truncate: another process may be reading the old file right now
+    if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        std::remove(path_.c_str());  // Windows won't rename over an existing file
+        if (std::rename(tmp.c_str(), path_.c_str()) != 0) return false;
+    }
+    std::string rest;
+    if (!readLog(path_, buf.size(), id, size, rest)) id = FileId();
+
+    offsets_.swap(newOffsets);
+    logId_ = id;
+    logEnd_ = buf.size();
+    logRecords_ = offsets_.size();
+    for (auto it = hot_.begin(); it != hot_.end();) {
+        if (it->second.removed) {
+            auto next = std::next(it);
+            dropHotLocked(it);
+            it = next;
+        } else {
+            it->second.dirty = false;
+            ++it;
+        }
+    }
+    return true;
+}
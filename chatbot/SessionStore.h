@@ -0,0 +1,196 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Everything needed to resume a conversation after the process restarts
+struct SessionState {
+    std::vector<std::string> topicStack;     // bottom .. top
+    std::vector<std::string> sessionTopics;  // topics visited this session, in order
+    // In-flight quiz (quizActive == false when none)
+    bool quizActive = false;
+    std::string quizTopic;
+    std::string quizDifficulty;
+    uint32_t quizIndex = 0;  // next question to ask
+    uint32_t quizScore = 0;  // correct answers so far
+    uint32_t quizVariant = 0;  // which questions of the quiz bank (QuizBank::quiz)
+    // Detail reply being streamed: the topic and where "more" continues (empty topic when none)
+    std::string streamTopic;
+    uint32_t streamOffset = 0;
+
+    bool operator==(const SessionState &o) const;
+    bool operator!=(const SessionState &o) const { return !(*this == o); }
+};
+
+// Maps topic (and difficulty) names to small integer ids and back
+class TopicInterner {
+public:
+    uint16_t intern(const std::string &name);
+    const std::string &name(uint16_t id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint16_t> ids_;
+};
+
+// Session snapshots in a compact binary log (data/user/sessions.snap), with two tiers:
+//  - hot:  recently active sessions, held in memory as CompactSession (interned ids
+//          in fixed-size buffers)
+//  - cold: sessions idle past the threshold or pushed out by the memory cap; only
+//          their file offset is kept and they are faulted back in by find()
+// checkpoint() appends only the sessions that changed since the last call, then
+// evicts idle sessions. restore() just indexes the log; nothing is decoded until used.
+// update() and remove() write nothing; once startWriter() has been called a background thread
+// checkpoints every kWriteInterval, so no chat turn waits for a session to be written. A turn
+// can still read from the log: find() (and update()) fault a cold session back in.
+//
+// File layout: "DSAS" magic, format version byte, then records of
+//   varint payloadLength | payload | uint32 FNV-1a checksum of payload
+// A torn record at the tail (crash mid-write) is ignored.
+//
+// Every process using the same data directory shares the log. Appends and compaction hold
+// an exclusive lock on <log>.lock (compaction replaces the log, so it cannot carry the lock);
+// the index picks up records other processes appended, and is rebuilt when the log was
+// replaced. The log is only ever appended to or replaced, never truncated.
+class SessionStore {
+public:
+    struct Stats {
+        size_t hot;
+        size_t cold;
+        size_t hotBytes;       // approximate memory held by hot sessions
+        uint64_t evictions;    // hot -> cold
+        uint64_t faults;       // cold -> hot
+    };
+
+    explicit SessionStore(const std::string &path);
+    ~SessionStore();  // stops the writer after a last checkpoint, releases the lock file
+
+    static constexpr std::chrono::milliseconds kWriteInterval{1000};
+    void startWriter();  // after restore()
+
+    // Memory caps: at most maxHot sessions / maxHotBytes in memory, and sessions untouched
+    // for idleTimeout are moved to disk at the next checkpoint.
+    // main.cpp sets them from --max-sessions, --max-session-mb and --session-idle-minutes.
+    void setLimits(size_t maxHot, size_t maxHotBytes, std::chrono::seconds idleTimeout);
+    static constexpr size_t kDefaultMaxHot = 10000;
+    static constexpr size_t kDefaultMaxHotBytes = 16 * 1024 * 1024;
+    static constexpr std::chrono::minutes kDefaultIdleTimeout{30};
+
+    // Record the latest state; it is written at the next checkpoint only if it changed
+    void update(const std::string &sessionId, const SessionState &state);
+    void remove(const std::string &sessionId);
+    bool find(const std::string &sessionId, SessionState &out);
+
+    // Id for a session nobody will ask for by name: prefix plus start time, process id and a
+    // random nonce, so servers and consoles sharing the log never pick the same one
+    static std::string uniqueId(const std::string &prefix);
+    // Names a user may pick to resume a session from anywhere ("user:<name>"): 1-64 of [A-Za-z0-9_-]
+    static bool validName(const std::string &name);
+
+    size_t checkpoint();  // returns the number of records written; the file is written outside mutex_
+    size_t restore();     // returns the number of sessions found in the log
+    size_t size() const;
+    Stats stats() const;
+
+private:
+    // Small fixed buffers cover normal sessions; the stack keeps only its newest
+    // kStack entries and rare long histories spill into moreTopics.
+    struct CompactSession {
+        static const int kStack = 16;
+        static const int kTopics = 24;
+        uint16_t stack[kStack];
+        uint16_t topics[kTopics];
+        std::vector<uint16_t> moreTopics;
+        uint8_t stackLen = 0;
+        uint8_t topicsLen = 0;
+        bool quizActive = false;
+        uint16_t quizTopic = 0;
+        uint16_t quizDifficulty = 0;
+        uint32_t quizIndex = 0;
+        uint32_t quizScore = 0;
+        uint32_t quizVariant = 0;
+        bool streaming = false;
+        uint16_t streamTopic = 0;
+        uint32_t streamOffset = 0;
+    };
+
+    struct Slot {
+        CompactSession session;
+        bool dirty = false;
+        bool removed = false;
+        uint64_t version = 0;  // bumped by every change, so a checkpoint can tell if one came in meanwhile
+        std::chrono::steady_clock::time_point lastTouch;
+        std::list<std::string>::iterator lru;
+    };
+
+    // Identifies the file behind path_ (device and inode, or volume and file index)
+    struct FileId {
+        uint64_t volume = 0;
+        uint64_t index = 0;
+        bool operator==(const FileId &o) const { return volume == o.volume && index == o.index; }
+        bool operator!=(const FileId &o) const { return !(*this == o); }
+    };
+
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::mutex checkpointMutex_;  // one checkpoint or restore at a time; taken before mutex_
+#ifdef _WIN32
+    void *lockHandle_ = nullptr;
+#else
+    int lockFd_ = -1;
+#endif
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    TopicInterner names_;
+    std::unordered_map<std::string, Slot> hot_;
+    std::list<std::string> lru_;                     // front = most recently used
+    std::unordered_map<std::string, uint64_t> offsets_;  // id -> offset of its latest record on disk
+    FileId logId_;         // the file offsets_ describes
+    uint64_t logEnd_ = 0;  // end of the last whole record indexed
+    size_t logRecords_ = 0;  // records in the file, live or superseded
+
+    size_t maxHot_ = kDefaultMaxHot;
+    size_t maxHotBytes_ = kDefaultMaxHotBytes;
+    std::chrono::seconds idleTimeout_{kDefaultIdleTimeout};
+    size_t hotBytes_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t faults_ = 0;
+
+    CompactSession compact(const SessionState &state);
+    SessionState expand(const CompactSession &c) const;
+    static size_t bytesOf(const std::string &id, const Slot &slot);
+
+    Slot &touchLocked(const std::string &id);
+    // If the session is hot: touches it and sets found (false for a tombstone) and out
+    bool hotLocked(const std::string &id, SessionState &out, bool &found);
+    void dropHotLocked(std::unordered_map<std::string, Slot>::iterator it);
+    void evictLocked(std::chrono::steady_clock::time_point now);
+    // Cross-process lock around appends and compaction; only under checkpointMutex_
+    bool lockLog();
+    void unlockLog();
+    // Index records appended since the last call (rebuilding it if the log was replaced).
+    // Returns false if the log has a torn tail or a bad header, which only compaction repairs.
+    bool syncIndexLocked();
+    bool compactLocked();  // with the log locked; false if the log could not be replaced
+    // The record at offset of the log file `log`; false if the log is another file now or the record
+    // does not fit in it. Needs no lock.
+    bool readRecord(const FileId &log, uint64_t offset, std::string &id, SessionState &state, bool &removed) const;
+
+    // Bytes [from, end) of the log, at most maxBytes of them, and which file they came from;
+    // false if it can't be opened
+    static bool readLog(const std::string &path, uint64_t from, FileId &id, uint64_t &size, std::string &data,
+                        uint64_t maxBytes = UINT64_MAX);
+    // Appends records at the end, after the header if the log is new; with the log locked
+    static bool appendLog(const std::string &path, const std::string &records);
+
+    static void encode(std::string &out, const std::string &id, const SessionState &state, bool removed);
+    static bool decode(const char *p, size_t len, std::string &id, SessionState &state, bool &removed);
+};
@@ -0,0 +1,68 @@
+#include "StartupTrace.h"
+#include <algorithm>
+#include <iomanip>
+
+StartupTrace::StartupTrace() : start_(Clock::now()) {}
+
+double StartupTrace::nowMs() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+int StartupTrace::threadIndexLocked() {
+    auto id = std::this_thread::get_id();
+    auto it = std::find(threads_.begin(), threads_.end(), id);
+    if (it != threads_.end()) return (int)(it - threads_.begin());
+    threads_.push_back(id);
+    return (int)threads_.size() - 1;
+}
+
+int StartupTrace::begin(const std::string &name) {
+    double t = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.push_back({name, std::string(), t, -1.0, threadIndexLocked()});
+    return (int)records_.size() - 1;
+}
+
+void StartupTrace::end(int index) {
+    double t = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_[index].endMs = t;
+}
+
+void StartupTrace::mark(const std::string &name) {
+    double t = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.push_back({name, std::string(), t, t, threadIndexLocked()});
+}
+
+void StartupTrace::print(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out << "Startup trace (ms since launch)\n";
+    out << "  " << std::left << std::setw(24) << "phase" << std::right << std::setw(9) << "start"
+        << std::setw(9) << "took" << std::setw(8) << "thread" << "\n";
+    out << std::fixed << std::setprecision(2);
+    for (auto &r : records_) {
+        out << "  " << std::left << std::setw(24) << r.name << std::right << std::setw(9) << r.startMs;
+        if (r.endMs < 0) out << std::setw(9) << "running";
+        else if (r.endMs == r.startMs) out << std::setw(9) << "-";
+        else out << std::setw(9) << r.endMs - r.startMs;
+        out << std::setw(8) << r.thread;
+        if (!r.detail.empty()) out << "  " << r.detail;
+        out << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+StartupTrace::Phase::Phase(StartupTrace *trace, const std::string &name) : trace_(trace) {
+    if (trace_) index_ = trace_->begin(name);
+}
+
+StartupTrace::Phase::~Phase() {
+    if (trace_) trace_->end(index_);
+}
+
+void StartupTrace::Phase::note(const std::string &detail) {
+    if (!trace_) return;
+    std::lock_guard<std::mutex> lock(trace_->mutex_);
+    trace_->records_[index_].detail = detail;
+}
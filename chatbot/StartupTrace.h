@@ -0,0 +1,49 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timings of the startup phases, printed by --startup-trace. Phases run on several
+// threads (corpus loading is parallel, the progress index is built in the background),
+// so each records its own start offset, duration and thread.
+class StartupTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Times one phase for its lifetime. A null trace makes it a no-op.
+    class Phase {
+    public:
+        Phase(StartupTrace *trace, const std::string &name);
+        ~Phase();
+        void note(const std::string &detail);  // shown next to the phase, e.g. "37 topics"
+    private:
+        StartupTrace *trace_;
+        int index_ = -1;
+    };
+
+    StartupTrace();  // the clock starts here
+    void mark(const std::string &name);  // an instant, e.g. "first prompt"
+    void print(std::ostream &out) const;
+
+private:
+    struct Record {
+        std::string name;
+        std::string detail;
+        double startMs;
+        double endMs;  // < 0 while the phase is still running
+        int thread;
+    };
+
+    Clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::vector<Record> records_;
+    std::vector<std::thread::id> threads_;  // thread ids in order of first appearance
+
+    double nowMs() const;
+    int begin(const std::string &name);
+    void end(int index);
+    int threadIndexLocked();
+};
@@ -0,0 +1,158 @@
+#include "TopicRecommender.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+static std::string trim(const std::string &s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// Build a CSR layout from an edge list (from -> to)
+static void buildCsr(int n, const std::vector<std::pair<int, int>> &edges, bool reverse,
+                     std::vector<int> &off, std::vector<int> &adj) {
+    off.assign(n + 1, 0);
+    for (auto &e : edges) off[(reverse ? e.second : e.first) + 1]++;
+    for (int i = 0; i < n; ++i) off[i + 1] += off[i];
+    adj.assign(edges.size(), 0);
+    std::vector<int> pos(off.begin(), off.end() - 1);
+    for (auto &e : edges) {
+        int from = reverse ? e.second : e.first;
+        adj[pos[from]++] = reverse ? e.first : e.second;
+    }
+}
+
+int TopicRecommender::idOf(const std::string &topic) const {
+    auto it = ids_.find(topic);
+    return it == ids_.end() ? -1 : it->second;
+}
+
+bool TopicRecommender::load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    names_.clear();
+    ids_.clear();
+    std::vector<std::pair<int, int>> edges;
+    auto intern = [&](const std::string &name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+        int id = (int)names_.size();
+        names_.push_back(name);
+        ids_[name] = id;
+        return id;
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t arrow = line.find("->");
+        if (arrow == std::string::npos) continue;
+        std::string from = trim(line.substr(0, arrow));
+        std::string to = trim(line.substr(arrow + 2));
+        if (from.empty() || to.empty() || from == to) continue;
+        edges.push_back({intern(from), intern(to)});
+    }
+
+    int n = (int)names_.size();
+    buildCsr(n, edges, false, nextOff_, next_);
+    buildCsr(n, edges, true, prevOff_, prev_);
+
+    // Kahn's algorithm; level = longest distance from any root
+    std::vector<int> indeg(n), queue;
+    level_.assign(n, -1);
+    for (int i = 0; i < n; ++i) {
+        indeg[i] = prevOff_[i + 1] - prevOff_[i];
+        if (indeg[i] == 0) { level_[i] = 0; queue.push_back(i); }
+    }
+    for (size_t qi = 0; qi < queue.size(); ++qi) {
+        int u = queue[qi];
+        for (int k = nextOff_[u]; k < nextOff_[u + 1]; ++k) {
+            int v = next_[k];
+            level_[v] = std::max(level_[v], level_[u] + 1);
+            if (--indeg[v] == 0) queue.push_back(v);
+        }
+    }
+    if ((int)queue.size() < n) {
+        std::cerr << "Warning: prerequisite graph has a cycle; affected topics are ignored.\n";
+        for (int i = 0; i < n; ++i) if (indeg[i] > 0) level_[i] = -1;
+    }
+
+    byLevel_.clear();
+    for (int i = 0; i < n; ++i) if (level_[i] >= 0) byLevel_.push_back(i);
+    std::stable_sort(byLevel_.begin(), byLevel_.end(), [&](int a, int b) { return level_[a] < level_[b]; });
+    return true;
+}
+
+int TopicRecommender::levelOf(const std::string &topic) const {
+    int id = idOf(topic);
+    return id < 0 ? -1 : level_[id];
+}
+
+TopicRecommender::Recommendation TopicRecommender::recommend(const std::vector<std::string> &visited,
+                                                             const ScoreFn &score,
+                                                             const std::string &current) const {
+    int n = (int)names_.size();
+    if (n == 0) return {};
+
+    // A topic counts as done once it was studied or quizzed
+    std::vector<char> done(n, 0);
+    std::vector<double> mastery(n, -1.0);
+    for (auto &t : visited) {
+        int id = idOf(t);
+        if (id >= 0) done[id] = 1;
+    }
+    if (score) {
+        for (int i = 0; i < n; ++i) {
+            mastery[i] = score(names_[i]);
+            if (mastery[i] >= 0) done[i] = 1;
+        }
+    }
+
+    auto ready = [&](int v) {
+        if (done[v] || level_[v] < 0) return false;
+        for (int k = prevOff_[v]; k < prevOff_[v + 1]; ++k) if (!done[prev_[k]]) return false;
+        return true;
+    };
+
+    // Prefer a direct successor of the current topic, then the shallowest ready topic
+    int pick = -1;
+    int cur = idOf(current);
+    if (cur >= 0) {
+        for (int k = nextOff_[cur]; k < nextOff_[cur + 1]; ++k) {
+            int v = next_[k];
+            if (ready(v) && (pick < 0 || level_[v] < level_[pick])) pick = v;
+        }
+    }
+    if (pick < 0) {
+        for (int v : byLevel_) if (ready(v)) { pick = v; break; }
+    }
+    if (pick < 0) return {};
+
+    // If a prerequisite of the pick was quizzed but not passed, review it first
+    int weak = -1;
+    for (int k = prevOff_[pick]; k < prevOff_[pick + 1]; ++k) {
+        int p = prev_[k];
+        if (mastery[p] >= 0 && mastery[p] < 60.0 && (weak < 0 || mastery[p] < mastery[weak])) weak = p;
+    }
+    if (weak >= 0) {
+        return {names_[weak], "your quiz average on it is " + std::to_string((int)(mastery[weak] + 0.5)) +
+                              "%, and " + names_[pick] + " builds on it"};
+    }
+
+    std::string reason;
+    int np = prevOff_[pick + 1] - prevOff_[pick];
+    if (np == 0) {
+        reason = "it is a good starting point";
+    } else {
+        reason = "it builds on ";
+        for (int k = prevOff_[pick]; k < prevOff_[pick + 1]; ++k) {
+            if (k > prevOff_[pick]) reason += (k + 1 == prevOff_[pick + 1]) ? " and " : ", ";
+            reason += names_[prev_[k]];
+        }
+    }
+    return {names_[pick], reason};
+}
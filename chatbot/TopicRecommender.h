@@ -0,0 +1,41 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Next-topic suggestions from a prerequisite graph (data/prerequisites.txt).
+// The graph is stored as a DAG in CSR form (offsets + flat edge array) for both
+// directions; topological levels are computed once at load time.
+class TopicRecommender {
+public:
+    // Quiz mastery lookup: mean score % for a topic, or a negative value if never quizzed
+    using ScoreFn = std::function<double(const std::string &)>;
+
+    struct Recommendation {
+        std::string topic;   // empty if nothing to suggest
+        std::string reason;
+    };
+
+    // Load "prereq -> topic" edges. Returns false if the file could not be read.
+    bool load(const std::string &path);
+    bool empty() const { return names_.empty(); }
+
+    // Suggest what to study next given the topics already seen, quiz scores and
+    // the current topic (may be "unknown").
+    Recommendation recommend(const std::vector<std::string> &visited, const ScoreFn &score,
+                             const std::string &current) const;
+
+    int levelOf(const std::string &topic) const;
+
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, int> ids_;
+    // CSR adjacency: successors of node i are next_[nextOff_[i] .. nextOff_[i+1])
+    std::vector<int> nextOff_, next_;
+    std::vector<int> prevOff_, prev_;
+    std::vector<int> level_;   // longest path from a root; -1 if on a cycle
+    std::vector<int> byLevel_; // node ids sorted by (level, id)
+
+    int idOf(const std::string &topic) const;
+};
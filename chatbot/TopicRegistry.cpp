@@ -0,0 +1,377 @@
+#include "TopicRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+static std::string trim(const std::string &s) {
+    size_t a = s.find_first_not_of(" \t\r");
+    if (a == std::string::npos) return std::string();
+    size_t b = s.find_last_not_of(" \t\r");
+    return s.substr(a, b - a + 1);
+}
+
+static std::string lowercase(std::string s) {
+    for (auto &c : s) c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+size_t TopicRegistry::headerLength(const std::string &content) {
+    size_t pos = 0;
+    while (pos < content.size() && content[pos] == '@') {
+        size_t nl = content.find('\n', pos);
+        if (nl == std::string::npos) return content.size();
+        pos = nl + 1;
+    }
+    return pos;
+}
+
+// Aliases and rank from the "@name: value" lines at the top of a topic file.
+// Plain stdio: with thousands of files, opening an ifstream per file costs more than reading them.
+static void readHeader(const std::string &path, std::vector<std::string> &aliases, int &rank) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return;
+    std::string line;
+    int c = std::fgetc(f);
+    while (c == '@') {
+        line.clear();
+        while ((c = std::fgetc(f)) != EOF && c != '\n') line += (char)c;
+        if (c != EOF) c = std::fgetc(f);
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = lowercase(trim(line.substr(0, colon)));
+        std::string value = trim(line.substr(colon + 1));
+        if (name == "aliases") {
+            std::istringstream ss(value);
+            std::string alias;
+            while (std::getline(ss, alias, ',')) aliases.push_back(alias);
+        } else if (name == "rank") {
+            rank = std::atoi(value.c_str());
+        }
+    }
+    std::fclose(f);
+}
+
+size_t TopicRegistry::scan(const std::string &topicsDir) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<std::pair<std::string, std::string>> files;  // (key, path)
+    for (fs::directory_iterator it(topicsDir, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path &p = it->path();
+        if (p.extension() != ".txt") continue;
+        std::string stem = p.stem().string();
+        if (stem.size() > 5 && stem.compare(stem.size() - 5, 5, "_quiz") == 0) continue;
+        files.push_back({stem, p.string()});
+    }
+    // Directory order is unspecified; sort so topic ids are stable between runs
+    std::sort(files.begin(), files.end());
+
+    // Opening thousands of files dominates, so headers are read on several threads;
+    // the trie is still built on this one, in sorted order
+    struct Header {
+        std::vector<std::string> aliases;
+        int rank = 0;
+    };
+    std::vector<Header> headers(files.size());
+    std::atomic<size_t> nextFile{0};
+    auto reader = [&]() {
+        for (size_t i; (i = nextFile++) < files.size();) readHeader(files[i].second, headers[i].aliases, headers[i].rank);
+    };
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                      files.size() / kFilesPerThread + 1);
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(reader);
+    reader();
+    for (auto &t : pool) t.join();
+
+    for (size_t i = 0; i < files.size(); ++i) addTopic(files[i].first, headers[i].aliases, headers[i].rank);
+    build();
+    return topics_.size();
+}
+
+void TopicRegistry::add(const std::string &key, const std::vector<std::string> &aliases, int rank) {
+    addTopic(key, aliases, rank);
+    build();
+}
+
+int TopicRegistry::addTopic(const std::string &key, const std::vector<std::string> &aliases, int rank) {
+    int id = find(key);
+    if (id < 0) {
+        id = (int)topics_.size();
+        topics_.push_back({key, {}, rank});
+        ids_[key] = id;
+    }
+    Topic &t = topics_[id];
+    t.rank = rank;
+
+    // The key itself always names the topic, with underscores read as spaces
+    std::vector<std::string> all = aliases;
+    std::string spaced = key;
+    std::replace(spaced.begin(), spaced.end(), '_', ' ');
+    all.push_back(key);
+    all.push_back(spaced);
+    for (auto &a : all) {
+        std::string alias = lowercase(trim(a));
+        if (alias.empty() || std::find(t.aliases.begin(), t.aliases.end(), alias) != t.aliases.end()) continue;
+        t.aliases.push_back(alias);
+        insert(alias, id);
+    }
+    return id;
+}
+
+int TopicRegistry::find(const std::string &key) const {
+    auto it = ids_.find(key);
+    return it == ids_.end() ? -1 : it->second;
+}
+
+int TopicRegistry::rank(const std::string &key) const {
+    int id = find(key);
+    return id < 0 ? 0 : topics_[id].rank;
+}
+
+int TopicRegistry::child(int node, unsigned char c) const {
+    const auto &next = nodes_[node].next;
+    auto it = std::lower_bound(next.begin(), next.end(), std::make_pair(c, 0));
+    return (it != next.end() && it->first == c) ? it->second : -1;
+}
+
+void TopicRegistry::insert(const std::string &alias, int topic) {
+    if (nodes_.empty()) nodes_.emplace_back();
+    int node = 0;
+    nodes_[0].maxAlias = std::max(nodes_[0].maxAlias, (int)alias.size());
+    for (char ch : alias) {
+        unsigned char c = (unsigned char)ch;
+        int nxt = child(node, c);
+        if (nxt < 0) {
+            nxt = (int)nodes_.size();
+            nodes_.emplace_back();
+            auto &next = nodes_[node].next;
+            next.insert(std::lower_bound(next.begin(), next.end(), std::make_pair(c, 0)), {c, nxt});
+        }
+        node = nxt;
+        nodes_[node].maxAlias = std::max(nodes_[node].maxAlias, (int)alias.size());
+    }
+    Node &end = nodes_[node];
+    if (end.out >= 0) {
+        // Two topics share an alias: the more specific one keeps it
+        Pattern &p = patterns_[end.out];
+        if (topics_[topic].rank > topics_[p.topic].rank) p.topic = topic;
+        return;
+    }
+    end.out = (int)patterns_.size();
+    patterns_.push_back({topic, (int)alias.size()});
+}
+
+void TopicRegistry::build() {
+    if (nodes_.empty()) return;
+    // Breadth-first, so a node's failure target is always finished before the node itself
+    std::queue<int> q;
+    nodes_[0].fail = 0;
+    nodes_[0].outLink = -1;
+    for (auto &e : nodes_[0].next) {
+        nodes_[e.second].fail = 0;
+        nodes_[e.second].outLink = -1;
+        q.push(e.second);
+    }
+    while (!q.empty()) {
+        int u = q.front();
+        q.pop();
+        for (auto &e : nodes_[u].next) {
+            int v = e.second;
+            int f = nodes_[u].fail;
+            while (f != 0 && child(f, e.first) < 0) f = nodes_[f].fail;
+            int target = child(f, e.first);
+            nodes_[v].fail = (target >= 0 && target != v) ? target : 0;
+            int fv = nodes_[v].fail;
+            nodes_[v].outLink = nodes_[fv].out >= 0 ? fv : nodes_[fv].outLink;
+            q.push(v);
+        }
+    }
+}
+
+static bool isWordChar(char c) {
+    return std::isalnum((unsigned char)c) != 0;
+}
+
+std::vector<int> TopicRegistry::match(const std::string &text) const {
+    struct Hit { int start, length, topic; };
+    std::vector<Hit> hits;
+    if (nodes_.empty()) return {};
+
+    int node = 0;
+    int n = (int)text.size();
+    for (int i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)text[i];
+        while (node != 0 && child(node, c) < 0) node = nodes_[node].fail;
+        int nxt = child(node, c);
+        node = nxt < 0 ? 0 : nxt;
+
+        for (int k = nodes_[node].out >= 0 ? node : nodes_[node].outLink; k >= 0; k = nodes_[k].outLink) {
+            const Pattern &p = patterns_[nodes_[k].out];
+            int start = i - p.length + 1;
+            // Whole words only, allowing a plural "s" ("queues", "graphs")
+            if (start > 0 && isWordChar(text[start - 1])) continue;
+            int after = i + 1;
+            if (after < n && text[after] == 's' && (after + 1 == n || !isWordChar(text[after + 1]))) after++;
+            if (after < n && isWordChar(text[after])) continue;
+            hits.push_back({start, p.length, p.topic});
+        }
+    }
+
+    // Leftmost-longest: drop hits that lie inside an earlier, longer one
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+        return a.start != b.start ? a.start < b.start : a.length > b.length;
+    });
+    std::vector<int> topics;
+    int coveredTo = -1;
+    for (auto &h : hits) {
+        if (h.start < coveredTo) continue;
+        coveredTo = h.start + h.length;
+        if (std::find(topics.begin(), topics.end(), h.topic) == topics.end()) topics.push_back(h.topic);
+    }
+    return topics;
+}
+
+std::string TopicRegistry::pairKey(const std::string &a, const std::string &b) {
+    return a < b ? a + "|" + b : b + "|" + a;
+}
+
+bool TopicRegistry::loadDifferences(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t p1 = line.find('|');
+        size_t p2 = p1 == std::string::npos ? p1 : line.find('|', p1 + 1);
+        if (p2 == std::string::npos) continue;
+        differences_[pairKey(trim(line.substr(0, p1)), trim(line.substr(p1 + 1, p2 - p1 - 1)))] = trim(line.substr(p2 + 1));
+    }
+    return true;
+}
+
+std::string TopicRegistry::difference(const std::string &a, const std::string &b) const {
+    auto it = differences_.find(pairKey(a, b));
+    return it == differences_.end() ? std::string() : it->second;
+}
+
+static int allowedEdits(int aliasLength) {
+    return aliasLength >= 8 ? 2 : aliasLength >= 5 ? 1 : 0;
+}
+
+// Depth-first walk of the alias trie (optimal string alignment distance, so "grpah"
+// is one edit from "graph"). rows[d][j] is the distance between the d characters on
+// the path to this node and the first j characters of the query. Only the band
+// |j - d| <= kMaxEdits is computed; anything outside it is over the limit anyway. A
+// branch is abandoned once its whole band exceeds the edits allowed for the longest
+// alias below it, so subtrees of short aliases are cut early.
+void TopicRegistry::fuzzyWalk(int node, int depth, unsigned char last, const FuzzyQuery &q, FuzzyRow *rows,
+                              FuzzyHit &best) const {
+    const int over = kMaxEdits + 1;
+    const Node &n = nodes_[node];
+    if (n.out >= 0) {
+        const Pattern &p = patterns_[n.out];
+        // Candidate spans end at word boundaries within the band
+        for (int e = 0; e < q.ends; ++e) {
+            int len = q.end[e];
+            if (len < depth - kMaxEdits || len > depth + kMaxEdits) continue;
+            int d = rows[depth][len];
+            bool better = d < best.distance ||
+                          (d == best.distance && (len > best.spanLength ||
+                          (len == best.spanLength && topics_[p.topic].rank > topics_[best.topic].rank)));
+            if (d <= allowedEdits(depth) && better) best = {d, len, p.topic};
+        }
+    }
+    if (depth >= q.length + kMaxEdits || n.next.empty()) return;
+    int budget = allowedEdits(n.maxAlias);
+
+    const int *prev = rows[depth];
+    int *row = rows[depth + 1];
+    int lo = std::max(1, depth + 1 - kMaxEdits);
+    int hi = std::min(q.length, depth + 1 + kMaxEdits);
+
+    auto step = [&](unsigned char c, int childNode) {
+        row[0] = std::min(depth + 1, over);
+        if (lo > 1) row[lo - 1] = over;
+        int rowMin = row[0];
+        for (int j = lo; j <= hi; ++j) {
+            int up = j <= depth + kMaxEdits ? prev[j] : over;
+            int v = std::min({up + 1, row[j - 1] + 1, prev[j - 1] + ((unsigned char)q.text[j - 1] == c ? 0 : 1)});
+            if (j > 1 && depth > 0 && (unsigned char)q.text[j - 1] == last && (unsigned char)q.text[j - 2] == c) {
+                v = std::min(v, rows[depth - 1][j - 2] + 1);  // swapped neighbours
+            }
+            row[j] = std::min(v, over);
+            rowMin = std::min(rowMin, row[j]);
+        }
+        if (rowMin <= allowedEdits(nodes_[childNode].maxAlias)) fuzzyWalk(childNode, depth + 1, c, q, rows, best);
+    };
+
+    // With the edit budget used up, only a child that matches a query character can stay
+    // in range, so look those up instead of trying every child
+    int bandMin = over;
+    for (int j = std::max(0, depth - kMaxEdits); j <= std::min(q.length, depth + kMaxEdits); ++j) bandMin = std::min(bandMin, prev[j]);
+    if (bandMin < budget) {
+        for (auto &e : n.next) step(e.first, e.second);
+        return;
+    }
+    unsigned char tried[2 * (2 * kMaxEdits + 1)];
+    int triedCount = 0;
+    auto tryChar = [&](unsigned char c) {
+        if (std::find(tried, tried + triedCount, c) != tried + triedCount) return;
+        tried[triedCount++] = c;
+        int childNode = child(node, c);
+        if (childNode >= 0) step(c, childNode);
+    };
+    for (int j = lo; j <= hi; ++j) {
+        if (prev[j - 1] <= budget) tryChar((unsigned char)q.text[j - 1]);
+        // A swap of neighbours can still come in under budget from two rows up
+        if (j > 1 && depth > 0 && (unsigned char)q.text[j - 1] == last && rows[depth - 1][j - 2] < budget) {
+            tryChar((unsigned char)q.text[j - 2]);
+        }
+    }
+}
+
+int TopicRegistry::fuzzyMatch(const std::string &text) const {
+    if (nodes_.empty()) return -1;
+
+    // Word boundaries, kept in fixed arrays
+    const int kMaxWords = 64;
+    int starts[kMaxWords], ends[kMaxWords];
+    int words = 0;
+    int n = (int)text.size();
+    for (int i = 0; i < n && words < kMaxWords;) {
+        while (i < n && text[i] == ' ') ++i;
+        if (i == n) break;
+        starts[words] = i;
+        while (i < n && text[i] != ' ') ++i;
+        ends[words++] = i;
+    }
+
+    // One walk per starting word covers the spans of 1, 2 and 3 words that start there
+    FuzzyRow rows[kMaxFuzzyLen + kMaxEdits + 1];
+    FuzzyHit best;
+    for (int w = 0; w < words; ++w) {
+        FuzzyQuery q;
+        q.text = text.data() + starts[w];
+        q.ends = 0;
+        for (int span = 0; span < 3 && w + span < words; ++span) {
+            int len = ends[w + span] - starts[w];
+            // Below 4 characters nothing is allowed an edit, and exact hits were already tried
+            if (len < 4 || len > kMaxFuzzyLen) continue;
+            if (text[starts[w] + len - 1] == 's' && len > 4) q.end[q.ends++] = len - 1;
+            q.end[q.ends++] = len;
+        }
+        if (q.ends == 0) continue;
+        q.length = q.end[q.ends - 1];
+        for (int j = 0; j <= q.length; ++j) rows[0][j] = std::min(j, kMaxEdits + 1);
+        fuzzyWalk(0, 0, 0, q, rows, best);
+    }
+    return best.topic;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Topics discovered by scanning data/topics at startup. Each topic file may begin with
+// a metadata header:
+//   @aliases: bst, binary search tree, binary-search-tree
+//   @rank: 20
+// Aliases are the phrases that mention the topic; rank breaks ties when one message
+// mentions several topics (higher = more specific, e.g. avl_tree > bst > binary_tree).
+// All aliases are compiled into one Aho-Corasick automaton, so matching a message costs
+// O(message length + matches) no matter how many topics there are.
+class TopicRegistry {
+public:
+    struct Topic {
+        std::string key;  // file stem, e.g. "linked_list"
+        std::vector<std::string> aliases;
+        int rank = 0;
+    };
+
+    // Register every <key>.txt (not *_quiz.txt) in the folder. Returns the topic count.
+    // Large folders are read on several threads; ids still follow sorted file order.
+    size_t scan(const std::string &topicsDir);
+    void add(const std::string &key, const std::vector<std::string> &aliases, int rank);
+    // Short comparison notes for topic pairs ("a | b | text" per line). Returns false if unreadable.
+    bool loadDifferences(const std::string &path);
+
+    // Topic ids mentioned in lowercase text, in order of first mention. Where aliases
+    // overlap ("binary search" inside "binary search tree") the longest one wins.
+    std::vector<int> match(const std::string &text) const;
+    // Typo-tolerant fallback for when match() finds nothing: the topic whose alias is closest
+    // (Levenshtein) to some 1-3 word span of text, or -1. Aliases of 5+ characters allow one
+    // edit, 8+ allow two. Walks the alias trie with fixed-size rows; no allocation per query.
+    int fuzzyMatch(const std::string &text) const;
+
+    size_t size() const { return topics_.size(); }
+    const Topic &topic(int id) const { return topics_[id]; }
+    int find(const std::string &key) const;  // -1 if unknown
+    int rank(const std::string &key) const;
+    std::string difference(const std::string &a, const std::string &b) const;  // empty if none
+
+    // Length of the leading "@name: value" lines of a topic file, so callers can strip them
+    static size_t headerLength(const std::string &content);
+
+private:
+    struct Node {
+        std::vector<std::pair<unsigned char, int>> next;  // sorted by character
+        int fail = 0;
+        int out = -1;      // alias ending here (index into patterns_), or -1
+        int outLink = -1;  // nearest node on the fail chain that has an alias
+        int maxAlias = 0;  // longest alias through this node (bounds the typo budget below it)
+    };
+    struct Pattern {
+        int topic;
+        int length;
+    };
+    static const size_t kFilesPerThread = 256;  // below this a scan stays on one thread
+    static const int kMaxEdits = 2;
+    static const int kMaxFuzzyLen = 48;  // longer spans are never typos of an alias
+    using FuzzyRow = int[kMaxFuzzyLen + 1];
+    struct FuzzyQuery {
+        const char *text;  // start of the span
+        int end[6];        // lengths of the 1, 2 and 3 word spans (and without a plural "s")
+        int ends;
+        int length;        // longest span
+    };
+    struct FuzzyHit {
+        int distance = kMaxEdits + 1;
+        int spanLength = 0;
+        int topic = -1;
+    };
+
+    std::vector<Topic> topics_;
+    std::unordered_map<std::string, int> ids_;
+    std::unordered_map<std::string, std::string> differences_;  // "a|b" with a < b
+    std::vector<Node> nodes_;
+    std::vector<Pattern> patterns_;
+
+    int child(int node, unsigned char c) const;
+    int addTopic(const std::string &key, const std::vector<std::string> &aliases, int rank);
+    void insert(const std::string &alias, int topic);
+    void build();  // failure links; run once after a batch of topics is added
+    void fuzzyWalk(int node, int depth, unsigned char last, const FuzzyQuery &q, FuzzyRow *rows, FuzzyHit &best) const;
+    static std::string pairKey(const std::string &a, const std::string &b);
+};
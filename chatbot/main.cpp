@@ -1,25 +1,103 @@
-#include <iostream>
-#include "DataManager.h"
-#include "ChatEngine.h"
-#include "QuizEngine.h"
-
-
-int main(int argc, char* argv[]) {
-    // Check for --test-mode flag
-    bool testMode = false;
-    for (int i = 1; i < argc; ++i) {
-        if (std::string(argv[i]) == "--test-mode") {
-            testMode = true;
-            break;
-        }
-    }
-    
-    QuizEngine::testMode = testMode;
-    
-    // base data path is ./data
-    std::string dataPath = "data";
-    DataManager dm(dataPath);
-    ChatEngine chat(dm);
-    chat.start();
-    return 0;
-}
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include "DataManager.h"
+#include "ChatEngine.h"
+#include "ChatServer.h"
+#include "CourseCatalog.h"
+#include "EventLog.h"
+#include "QuizEngine.h"
+#include "StartupTrace.h"
+
+
+int main(int argc, char* argv[]) {
+    StartupTrace trace;
+    // Check for --test-mode flag
+    bool testMode = false;
+    bool traceStartup = false;  // --startup-trace: print where the time to the first prompt went
+    bool eventLog = true;       // --no-event-log: do not record turns to data/user/events.log
+    int servePort = 0;  // --serve <port>: multiplex TCP clients instead of the console
+    std::string course;  // --course <name>: study data/courses/<name> instead of the default course
+    std::string session;  // --session <name>: resume (and keep) the named session "user:<name>"
+    // Per course: --max-sessions <n> in memory, --max-session-mb <n> of them, and sessions idle
+    // for --session-idle-minutes <n> go to disk (SessionStore::setLimits)
+    size_t maxSessions = SessionStore::kDefaultMaxHot;
+    size_t maxSessionMb = SessionStore::kDefaultMaxHotBytes >> 20;
+    long idleMinutes = (long)SessionStore::kDefaultIdleTimeout.count();
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--test-mode") {
+            testMode = true;
+        } else if (std::string(argv[i]) == "--startup-trace") {
+            traceStartup = true;
+        } else if (std::string(argv[i]) == "--no-event-log") {
+            eventLog = false;
+        } else if (std::string(argv[i]) == "--serve" && i + 1 < argc) {
+            servePort = std::atoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--course" && i + 1 < argc) {
+            course = argv[++i];
+        } else if (std::string(argv[i]) == "--session" && i + 1 < argc) {
+            session = argv[++i];
+        } else if (std::string(argv[i]) == "--max-sessions" && i + 1 < argc) {
+            maxSessions = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::string(argv[i]) == "--max-session-mb" && i + 1 < argc) {
+            maxSessionMb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::string(argv[i]) == "--session-idle-minutes" && i + 1 < argc) {
+            idleMinutes = std::strtol(argv[++i], nullptr, 10);
+        }
+    }
+    
+    QuizEngine::testMode = testMode;
+    
+    // base data path is ./data
+    std::filesystem::path dataPath = "data";
+    StartupTrace *startupTrace = traceStartup ? &trace : nullptr;
+    auto applySessionLimits = [&](DataManager &dm) {
+        dm.sessions().setLimits(maxSessions, maxSessionMb << 20, std::chrono::minutes(std::max(idleMinutes, 1L)));
+    };
+    if (eventLog && !EventLog::shared().open((dataPath / "user" / "events.log").string())) {
+        std::cout << "Could not open the event log; turns will not be recorded.\n";
+    }
+    if (servePort > 0) {
+        // Every course is served; clients choose one with "course <name>"
+        CourseCatalog courses(dataPath, startupTrace);
+        applySessionLimits(courses.defaultCourse());
+        for (auto &name : courses.names()) applySessionLimits(*courses.find(name));
+        ChatServer server(courses, servePort);
+        if (traceStartup) {
+            trace.mark("accepting clients");
+            trace.print(std::cout);
+            std::cout.flush();  // the server may run for a long time with stdout redirected
+        }
+        return server.run();
+    }
+    std::filesystem::path coursePath = dataPath;
+    if (!course.empty() && course != "default") {
+        coursePath = dataPath / "courses" / course;
+        if (!std::filesystem::is_directory(coursePath / "topics")) {
+            std::cout << "No course named '" << course << "' (expected " << (coursePath / "topics").string() << ")\n";
+            return 1;
+        }
+    } else {
+        course.clear();
+    }
+    if (!session.empty() && !SessionStore::validName(session)) {
+        std::cout << "A session name is 1-64 letters, digits, '_' or '-'\n";
+        return 1;
+    }
+    DataManager dm(coursePath, course, startupTrace);
+    applySessionLimits(dm);
+    // Named like the server's "session <name>", so either can resume it; otherwise an id no
+    // other console or server sharing the data directory uses
+    std::string sessionId = session.empty() ? SessionStore::uniqueId("local") : "user:" + session;
+    ChatEngine chat(dm, sessionId);
+    if (traceStartup) {
+        trace.mark("first prompt");
+        trace.print(std::cout);
+    }
+    chat.start();
+    if (session.empty()) dm.sessions().remove(sessionId);  // nobody can ask for it again
+    if (traceStartup) trace.print(std::cout);  // again, now that the background phases have finished
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Algorithm benchmark: times the chatbot's own algorithm library (Algorithms.cpp, the code behind
+// "show quicksort on ...") on random inputs of growing size, like the 'benchmark' chat command
+// but with a larger budget, and prints the table, the growth it measured and a log-log plot.
+//
+// Build (from the chatbot folder):
+//   g++ -std=c++17 -O2 tools/algobench.cpp Algorithms.cpp ComplexityLab.cpp -o algobench.exe
+// Run:
+//   .\algobench.exe                                  (every algorithm, one at a time)
+//   .\algobench.exe quicksort "merge sort" --sizes 1000,10000,100000 --budget 20
+#include "../ComplexityLab.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+    std::vector<const Algorithms::Info *> algos;
+    ComplexityLab::Options opt;
+    opt.sizes = ComplexityLab::defaultSizes();
+    opt.budget = std::chrono::seconds(10);
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--sizes" && i + 1 < argc) {
+            opt.sizes.clear();
+            std::istringstream ss(argv[++i]);
+            for (std::string n; std::getline(ss, n, ',');) opt.sizes.push_back(std::strtoull(n.c_str(), nullptr, 10));
+        } else if (a == "--budget" && i + 1 < argc) {
+            opt.budget = std::chrono::milliseconds((long long)(std::atof(argv[++i]) * 1000));
+        } else if (a == "--seed" && i + 1 < argc) {
+            opt.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (const Algorithms::Info *algo = Algorithms::find(a)) {
+            algos.push_back(algo);
+        } else {
+            std::fprintf(stderr, "usage: algobench [algorithm...] [--sizes n,n,...] [--budget sec] [--seed s]\n");
+            std::fprintf(stderr, "unknown algorithm or option: %s\n", a.c_str());
+            return 1;
+        }
+    }
+    for (size_t n : opt.sizes) {
+        if (n < 2 || n > Algorithms::kMaxRandom) {
+            std::fprintf(stderr, "sizes must be between 2 and %zu\n", Algorithms::kMaxRandom);
+            return 1;
+        }
+    }
+    std::sort(opt.sizes.begin(), opt.sizes.end());
+    if (algos.empty())
+        for (auto &algo : Algorithms::all()) algos.push_back(&algo);
+
+    // Each algorithm gets the whole budget here, and a table of its own
+    for (auto *algo : algos) {
+        auto series = ComplexityLab::run({algo}, opt);
+        std::printf("%s  (taught: %s)\n%s\n%s\n", algo->title, algo->complexity,
+                    ComplexityLab::table(series).c_str(), ComplexityLab::plot(series).c_str());
+    }
+    return 0;
+}
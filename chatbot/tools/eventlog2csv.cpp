@@ -0,0 +1,131 @@
+// Event log converter: turns the binary turn log written by the chatbot (data/user/events.log
+// and its rotated copies events.log.1, .2, ...) into CSV, one row per turn.
+//
+// Build (from the chatbot folder):
+//   g++ -std=c++17 -O2 tools/eventlog2csv.cpp -o eventlog2csv.exe
+// Run:
+//   .\eventlog2csv.exe data\user\events.log.1 data\user\events.log > events.csv
+//   .\eventlog2csv.exe -o events.csv data\user\events.log
+#include "../EventLog.h"
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Quote a field when it holds a separator, a quote or a line break
+static std::string csvField(const std::string &s) {
+    if (s.find_first_of(",\"\r\n") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string isoTime(int64_t us) {
+    std::time_t secs = (std::time_t)(us / 1000000);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &secs);
+#else
+    gmtime_r(&secs, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    char frac[16];
+    std::snprintf(frac, sizeof(frac), ".%06dZ", (int)(us % 1000000));
+    return std::string(buf) + frac;
+}
+
+// Reads fixed-size values and length-prefixed strings from one record, with bounds checks
+struct Reader {
+    const char *p;
+    const char *end;
+    bool ok = true;
+
+    template <typename T> T get() {
+        T v{};
+        if (end - p < (long)sizeof(T)) { ok = false; return v; }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    std::string str() {
+        uint16_t n = get<uint16_t>();
+        if (!ok || end - p < n) { ok = false; return std::string(); }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+// Returns the number of rows written, or -1 if the file is not an event log
+static long convert(const std::string &path, std::ostream &out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return -1;
+    char magic[EventLog::kMagicLength];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, EventLog::kMagic, sizeof(magic)) != 0) return -1;
+
+    long rows = 0;
+    std::vector<char> record;
+    uint32_t size;
+    while (in.read((char *)&size, 4)) {
+        record.resize(size);
+        if (!in.read(record.data(), size)) break;  // cut short by a crash: keep what came before
+        Reader r{record.data(), record.data() + size};
+        int64_t ts = r.get<int64_t>();
+        uint32_t latency = r.get<uint32_t>();
+        float faq = r.get<float>();
+        std::string session = r.str(), input = r.str(), intent = r.str(), topic = r.str(), branch = r.str();
+        if (!r.ok) break;
+        uint32_t firstByte = r.p < r.end ? r.get<uint32_t>() : latency;  // older logs: no reply before the end
+        out << isoTime(ts) << "," << ts << "," << csvField(session) << "," << csvField(input) << ","
+            << csvField(intent) << "," << csvField(topic) << "," << csvField(branch) << "," << latency << ","
+            << firstByte << ",";
+        if (faq >= 0) out << faq;
+        out << "\n";
+        rows++;
+    }
+    return rows;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> inputs;
+    std::string outPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-o" && i + 1 < argc) outPath = argv[++i];
+        else inputs.push_back(a);
+    }
+    if (inputs.empty()) {
+        std::cout << "Usage: eventlog2csv [-o out.csv] <events.log> [more logs, oldest first]\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream &out = outPath.empty() ? std::cout : file;
+    out << "time,timestamp_us,session,input,intent,topic,branch,latency_us,first_byte_us,faq_score\n";
+
+    int status = 0;
+    for (auto &path : inputs) {
+        long rows = convert(path, out);
+        if (rows < 0) {
+            std::cerr << path << ": not an event log\n";
+            status = 1;
+        } else {
+            std::cerr << path << ": " << rows << " events\n";
+        }
+    }
+    return status;
+}
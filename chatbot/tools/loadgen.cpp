@@ -0,0 +1,482 @@
+// Load generator: replays a seeded corpus of conversations against the chat engine,
+// in-process or over the --serve socket, and reports throughput, latency percentiles
+// and errors. The same seed always produces the same corpus and think times.
+//
+// Build (from the chatbot folder):
+//   g++ -std=c++17 -O2 -pthread tools/loadgen.cpp NLP.cpp ChatEngine.cpp DataManager.cpp QuizEngine.cpp
+//       LearningAnalytics.cpp TopicRecommender.cpp ResponseCache.cpp SessionStore.cpp ChatServer.cpp TopicRegistry.cpp
+//       IntentClassifier.cpp StartupTrace.cpp EventLog.cpp ContentPool.cpp CourseCatalog.cpp ProgressStore.cpp
+//       QuizBank.cpp Algorithms.cpp ComplexityLab.cpp ConversationContext.cpp -o loadgen.exe
+// Run:
+//   .\loadgen.exe --users 200 --turns 40 --threads 4 --seed 7
+//   ./loadgen.exe --connect 127.0.0.1:5555 --users 500 --think-ms 200-1500
+//   .\loadgen.exe --save-corpus corpus.txt   /   .\loadgen.exe --corpus corpus.txt
+//   .\loadgen.exe --event-log events.log     (log every in-process turn, as the chatbot does)
+#include "../ChatEngine.h"
+#include "../DataManager.h"
+#include "../EventLog.h"
+#include "../QuizEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Turn {
+    std::string kind;  // learn, detail, example, difference, faq, quiz, progress, recommend, exit
+    std::string text;
+    int thinkMs;       // pause before sending this turn
+};
+using Conversation = std::vector<Turn>;
+
+struct Options {
+    std::string dataPath = "data";
+    int users = 50;
+    int turns = 40;      // approximate turns per user, before the closing exit
+    int threads = 1;
+    uint64_t seed = 1;
+    int thinkMin = 0, thinkMax = 0;
+    std::string connect;  // host:port; empty = in-process
+    std::string corpusIn, corpusOut;
+    std::string eventLog;  // record in-process turns here, to measure the logging overhead
+};
+
+// ---- corpus -----------------------------------------------------------------
+
+// Topic phrasings the NLP layer recognizes, in the style of the greeting's suggestions
+static const std::vector<std::string> kTopics = {
+    "bst", "queue", "linked list", "array", "binary tree", "stack", "graphs", "sorting",
+    "hashing", "recursion", "heap", "avl tree", "merge sort", "complexity", "searching"};
+static const std::vector<std::string> kTopicKeys = {
+    "bst", "queue", "linked_list", "array", "binary_tree", "stack", "graph_basic", "sorting_elementary",
+    "hashing", "recursion_stack", "binary_heap", "avl_tree", "sorting_advanced", "complexity", "searching"};
+static const std::vector<std::pair<std::string, std::string>> kPairs = {
+    {"array", "linked list"}, {"stack", "queue"}, {"bst", "binary tree"}, {"bst", "avl tree"},
+    {"queue", "deque"}, {"array", "vector"}, {"dfs", "bfs"}, {"heap", "bst"}};
+
+// Relative frequency of each kind of turn in a generated conversation
+static const std::vector<std::pair<std::string, int>> kMix = {
+    {"learn", 30}, {"detail", 12}, {"example", 15}, {"difference", 10},
+    {"faq", 10}, {"quiz", 10}, {"progress", 5}, {"recommend", 8}};
+
+// FAQ questions straight from the topic files, so FAQ turns hit the FAQ matcher
+static std::vector<std::string> loadFaqQuestions(DataManager &dm) {
+    std::vector<std::string> out;
+    for (auto &t : kTopicKeys) {
+        std::istringstream ss(dm.loadTopicSection(t, "FAQ"));
+        std::string line;
+        while (std::getline(ss, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.rfind("Q:", 0) == 0) out.push_back(line.substr(2));
+        }
+    }
+    if (out.empty()) out.push_back("when to use a stack?");
+    return out;
+}
+
+static Conversation generateConversation(const Options &opt, int user, const std::vector<std::string> &faqs) {
+    // One generator per user, so the corpus does not depend on the thread count
+    std::mt19937_64 rng(opt.seed * 0x9E3779B97F4A7C15ULL + (uint64_t)user);
+    auto pick = [&](size_t n) { return (size_t)(rng() % n); };
+    auto think = [&]() {
+        if (opt.thinkMax <= opt.thinkMin) return opt.thinkMin;
+        return opt.thinkMin + (int)(rng() % (uint64_t)(opt.thinkMax - opt.thinkMin + 1));
+    };
+    int totalWeight = 0;
+    for (auto &m : kMix) totalWeight += m.second;
+
+    Conversation c;
+    auto add = [&](const std::string &kind, const std::string &text) { c.push_back({kind, text, think()}); };
+    while ((int)c.size() < opt.turns) {
+        int r = (int)pick((size_t)totalWeight);
+        std::string kind;
+        for (auto &m : kMix) {
+            if (r < m.second) { kind = m.first; break; }
+            r -= m.second;
+        }
+        const std::string &topic = kTopics[pick(kTopics.size())];
+        if (kind == "learn") {
+            static const char *forms[] = {"teach me ", "what is ", "explain ", "tell me about "};
+            add(kind, forms[pick(4)] + topic);
+        } else if (kind == "detail") {
+            // A follow-up that relies on the context topic
+            add("learn", "teach me " + topic);
+            add(kind, pick(2) ? "explain in detail" : "tell me more");
+        } else if (kind == "example") {
+            add(kind, pick(2) ? "give example of " + topic : "pseudocode for " + topic);
+        } else if (kind == "difference") {
+            auto &p = kPairs[pick(kPairs.size())];
+            add(kind, pick(2) ? "difference between " + p.first + " and " + p.second : p.first + " vs " + p.second);
+        } else if (kind == "faq") {
+            add(kind, faqs[pick(faqs.size())]);
+        } else if (kind == "quiz") {
+            // Difficulty, two answers, leave early, decline to save
+            add(kind, "quiz me on " + topic);
+            add(kind, std::to_string(1 + pick(3)));
+            add(kind, pick(2) ? "lifo" : "array");
+            add(kind, pick(2) ? "first in first out" : "o(n)");
+            add(kind, "exit");
+            add(kind, "no");
+        } else if (kind == "progress") {
+            add(kind, "show progress");
+            add(kind, "loaduser" + std::to_string(user % 10));
+        } else {
+            add(kind, "what should i study next");
+        }
+    }
+    add("exit", "exit");
+    add("exit", "no");
+    return c;
+}
+
+// Corpus file: one "kind<TAB>thinkMs<TAB>text" line per turn, a blank line between conversations
+static bool saveCorpus(const std::string &path, const std::vector<Conversation> &corpus) {
+    std::ofstream out(path);
+    if (!out) return false;
+    for (auto &c : corpus) {
+        for (auto &t : c) out << t.kind << '\t' << t.thinkMs << '\t' << t.text << "\n";
+        out << "\n";
+    }
+    return true;
+}
+
+static bool loadCorpus(const std::string &path, std::vector<Conversation> &corpus) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    Conversation cur;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) {
+            if (!cur.empty()) corpus.push_back(std::move(cur));
+            cur.clear();
+            continue;
+        }
+        size_t a = line.find('\t'), b = line.find('\t', a == std::string::npos ? a : a + 1);
+        if (a == std::string::npos || b == std::string::npos) continue;
+        cur.push_back({line.substr(0, a), line.substr(b + 1), std::atoi(line.substr(a + 1, b - a - 1).c_str())});
+    }
+    if (!cur.empty()) corpus.push_back(std::move(cur));
+    return true;
+}
+
+// ---- drivers ----------------------------------------------------------------
+
+// Sends one turn and returns the reply text; ok = false on a transport failure
+class Driver {
+public:
+    virtual ~Driver() {}
+    virtual bool open(int user) = 0;
+    virtual std::string send(const std::string &line, bool &ok, bool &ended) = 0;
+};
+
+class InProcessDriver : public Driver {
+public:
+    explicit InProcessDriver(DataManager &dm) : dm_(dm) {}
+    bool open(int user) override {
+        chat_.reset(new ChatEngine(dm_, "load-" + std::to_string(user), out_));
+        chat_->setTypingEffect(false);
+        chat_->greet();
+        out_.str("");
+        return true;
+    }
+    std::string send(const std::string &line, bool &ok, bool &ended) override {
+        ok = true;
+        ended = !chat_->handleMessage(line);
+        std::string reply = out_.str();
+        out_.str("");
+        return reply;
+    }
+private:
+    DataManager &dm_;
+    std::ostringstream out_;
+    std::unique_ptr<ChatEngine> chat_;
+};
+
+#ifdef __linux__
+class SocketDriver : public Driver {
+public:
+    SocketDriver(const std::string &host, int port) : host_(host), port_(port) {}
+    ~SocketDriver() override { if (fd_ >= 0) close(fd_); }
+    bool open(int) override {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) return false;
+        timeval tv{10, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port_);
+        if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) != 1) return false;
+        if (connect(fd_, (sockaddr *)&addr, sizeof(addr)) < 0) return false;
+        bool ok;
+        readUntil("\n", ok);  // banner
+        return ok;
+    }
+    std::string send(const std::string &line, bool &ok, bool &ended) override {
+        std::string msg = line + "\n";
+        ended = false;
+        ok = ::send(fd_, msg.data(), msg.size(), MSG_NOSIGNAL) == (ssize_t)msg.size();
+        if (!ok) return std::string();
+        std::string reply = readUntil("", ok);
+        // The server closes the connection once the conversation is over
+        if (!ok && reply.find("Bye!") != std::string::npos) ok = ended = true;
+        return reply;
+    }
+private:
+    std::string host_;
+    int port_;
+    int fd_ = -1;
+
+    // Every reply ends with a prompt: "You: ", a quiz "> " or a question ending in ": " / "?  "
+    static bool endsWithPrompt(const std::string &s) {
+        auto ends = [&](const char *p) {
+            size_t n = std::char_traits<char>::length(p);
+            return s.size() >= n && s.compare(s.size() - n, n, p) == 0;
+        };
+        return ends(": ") || ends("> ") || ends("?  ");
+    }
+    std::string readUntil(const char *terminator, bool &ok) {
+        std::string got;
+        char buf[8192];
+        while (true) {
+            ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+            if (n <= 0) { ok = false; return got; }
+            got.append(buf, (size_t)n);
+            if (*terminator ? got.find(terminator) != std::string::npos : endsWithPrompt(got)) break;
+        }
+        ok = true;
+        return got;
+    }
+};
+#endif
+
+// ---- measurement ------------------------------------------------------------
+
+struct Results {
+    std::map<std::string, std::vector<uint32_t>> latencyUs;  // per kind
+    uint64_t turns = 0;
+    uint64_t errors = 0;     // transport failures or conversations that ended early
+    uint64_t unhandled = 0;  // replies that fell through to "Sorry..." / "didn't quite understand"
+
+    void merge(const Results &o) {
+        for (auto &kv : o.latencyUs) {
+            auto &v = latencyUs[kv.first];
+            v.insert(v.end(), kv.second.begin(), kv.second.end());
+        }
+        turns += o.turns;
+        errors += o.errors;
+        unhandled += o.unhandled;
+    }
+};
+
+static std::unique_ptr<Driver> makeDriver(const Options &opt, DataManager &dm) {
+    if (opt.connect.empty()) return std::unique_ptr<Driver>(new InProcessDriver(dm));
+#ifdef __linux__
+    size_t colon = opt.connect.rfind(':');
+    return std::unique_ptr<Driver>(new SocketDriver(opt.connect.substr(0, colon), std::atoi(opt.connect.substr(colon + 1).c_str())));
+#else
+    return nullptr;
+#endif
+}
+
+// Runs a share of the users on one thread. Users take turns by think-time deadline,
+// so a thread keeps many conversations in flight like a real front end would.
+static Results runUsers(const Options &opt, DataManager &dm, const std::vector<Conversation> &corpus,
+                        const std::vector<int> &users) {
+    Results res;
+    struct Live {
+        std::unique_ptr<Driver> driver;
+        size_t next = 0;
+    };
+    std::vector<Live> live(users.size());
+    using Slot = std::pair<Clock::time_point, size_t>;
+    std::priority_queue<Slot, std::vector<Slot>, std::greater<Slot>> ready;
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < users.size(); ++i) {
+        live[i].driver = makeDriver(opt, dm);
+        if (!live[i].driver || !live[i].driver->open(users[i])) {
+            res.errors++;
+            continue;
+        }
+        const Conversation &c = corpus[users[i]];
+        if (!c.empty()) ready.push({start + std::chrono::milliseconds(c[0].thinkMs), i});
+    }
+
+    while (!ready.empty()) {
+        Slot s = ready.top();
+        ready.pop();
+        std::this_thread::sleep_until(s.first);
+
+        Live &l = live[s.second];
+        const Conversation &c = corpus[users[s.second]];
+        const Turn &t = c[l.next++];
+
+        bool ok = false, ended = false;
+        Clock::time_point t0 = Clock::now();
+        std::string reply;
+        try {
+            reply = l.driver->send(t.text, ok, ended);
+        } catch (const std::exception &) {
+            ok = false;
+        }
+        Clock::time_point t1 = Clock::now();
+
+        res.turns++;
+        res.latencyUs[t.kind].push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+        if (reply.find("Sorry, I couldn't handle") != std::string::npos ||
+            reply.find("didn't quite understand") != std::string::npos) res.unhandled++;
+
+        // Ending early is fine if only the closing turns are left (nothing to save, no prompt)
+        bool last = l.next >= c.size() || c[l.next].kind == "exit";
+        if (!ok || (ended && !last)) {
+            // The conversation is out of step with the script; drop the rest of it
+            res.errors++;
+            continue;
+        }
+        if (!ended && l.next < c.size()) ready.push({t1 + std::chrono::milliseconds(c[l.next].thinkMs), s.second});
+    }
+    return res;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static void report(Results &res, double seconds) {
+    std::vector<uint32_t> all;
+    std::cout << std::left << std::setw(12) << "kind" << std::right << std::setw(8) << "turns"
+              << std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "max us" << "\n";
+    for (auto &kv : res.latencyUs) {
+        auto &v = kv.second;
+        std::sort(v.begin(), v.end());
+        all.insert(all.end(), v.begin(), v.end());
+        std::cout << std::left << std::setw(12) << kv.first << std::right << std::setw(8) << v.size()
+                  << std::setw(10) << percentile(v, 50) << std::setw(10) << percentile(v, 90)
+                  << std::setw(10) << percentile(v, 99) << std::setw(10) << (v.empty() ? 0 : v.back()) << "\n";
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << std::left << std::setw(12) << "all" << std::right << std::setw(8) << all.size()
+              << std::setw(10) << percentile(all, 50) << std::setw(10) << percentile(all, 90)
+              << std::setw(10) << percentile(all, 99) << std::setw(10) << (all.empty() ? 0 : all.back()) << "\n\n";
+    std::cout << "Turns: " << res.turns << " in " << std::fixed << std::setprecision(2) << seconds << " s ("
+              << std::setprecision(0) << (seconds > 0 ? res.turns / seconds : 0.0) << " turns/s)\n";
+    std::cout << "Errors: " << res.errors << ", unhandled replies: " << res.unhandled << "\n";
+}
+
+static bool parseArgs(int argc, char *argv[], Options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--data") opt.dataPath = value();
+        else if (a == "--users") opt.users = std::atoi(value().c_str());
+        else if (a == "--turns") opt.turns = std::atoi(value().c_str());
+        else if (a == "--threads") opt.threads = std::max(1, std::atoi(value().c_str()));
+        else if (a == "--seed") opt.seed = std::strtoull(value().c_str(), nullptr, 10);
+        else if (a == "--connect") opt.connect = value();
+        else if (a == "--corpus") opt.corpusIn = value();
+        else if (a == "--save-corpus") opt.corpusOut = value();
+        else if (a == "--event-log") opt.eventLog = value();
+        else if (a == "--think-ms") {
+            std::string v = value();
+            size_t dash = v.find('-');
+            opt.thinkMin = std::atoi(v.substr(0, dash).c_str());
+            opt.thinkMax = dash == std::string::npos ? opt.thinkMin : std::atoi(v.substr(dash + 1).c_str());
+        } else {
+            std::cout << "Unknown option: " << a << "\n"
+                      << "Options: --data <dir> --users N --turns N --threads N --seed N --think-ms MIN-MAX\n"
+                      << "         --connect host:port --corpus <file> --save-corpus <file> --event-log <file>\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 1;
+    QuizEngine::testMode = true;  // no difficulty menu in the replies
+
+    DataManager dm(opt.dataPath);
+    std::vector<Conversation> corpus;
+    if (!opt.corpusIn.empty()) {
+        if (!loadCorpus(opt.corpusIn, corpus)) {
+            std::cout << "Unable to read corpus: " << opt.corpusIn << "\n";
+            return 1;
+        }
+    } else {
+        auto faqs = loadFaqQuestions(dm);
+        for (int u = 0; u < opt.users; ++u) corpus.push_back(generateConversation(opt, u, faqs));
+    }
+    if (!opt.corpusOut.empty()) {
+        if (!saveCorpus(opt.corpusOut, corpus)) {
+            std::cout << "Unable to write corpus: " << opt.corpusOut << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << corpus.size() << " conversations to " << opt.corpusOut << "\n";
+        return 0;
+    }
+#ifndef __linux__
+    if (!opt.connect.empty()) {
+        std::cout << "--connect is only supported on Linux.\n";
+        return 1;
+    }
+#endif
+
+    if (!opt.eventLog.empty() && !EventLog::shared().open(opt.eventLog)) {
+        std::cout << "Unable to open event log: " << opt.eventLog << "\n";
+        return 1;
+    }
+
+    // Deal users round-robin to the threads
+    std::vector<std::vector<int>> shares(opt.threads);
+    for (int u = 0; u < (int)corpus.size(); ++u) shares[u % opt.threads].push_back(u);
+
+    Results total;
+    std::mutex totalMutex;
+    Clock::time_point t0 = Clock::now();
+    std::vector<std::thread> workers;
+    for (auto &share : shares) {
+        workers.emplace_back([&, share]() {
+            Results r = runUsers(opt, dm, corpus, share);
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(r);
+        });
+    }
+    for (auto &w : workers) w.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::cout << corpus.size() << " users, " << opt.threads << " thread(s), seed " << opt.seed
+              << (opt.connect.empty() ? ", in-process" : ", server " + opt.connect) << "\n\n";
+    report(total, seconds);
+    if (EventLog::shared().isOpen()) {
+        EventLog::shared().close();
+        auto st = EventLog::shared().stats();
+        std::cout << "Event log: " << st.recorded << " events, " << st.dropped << " dropped, "
+                  << st.bytesWritten << " bytes\n";
+    }
+    return total.errors ? 2 : 0;
+}
@@ -0,0 +1,104 @@
+// Regression checks for the parts of the chatbot that decide what a message means: intent and
+// topic parsing, quiz answer matching, and carrying a conversation over to a rescanned registry. Prints each failed check and exits non-zero if any.
+//
+// Build (from the chatbot folder):
+//   g++ -std=c++17 -O2 -pthread tools/selftest.cpp NLP.cpp TopicRegistry.cpp IntentClassifier.cpp QuizBank.cpp LearningAnalytics.cpp ConversationContext.cpp -o selftest.exe
+// Run:
+//   .\selftest.exe --data data
+#include "../ConversationContext.h"
+#include "../IntentClassifier.h"
+#include "../NLP.h"
+#include "../QuizBank.h"
+#include "../TopicRegistry.h"
+#include <cstdio>
+#include <string>
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL: %s\n", what.c_str());
+}
+
+// Intent of `message` as parsed with and without the intent model
+static void expectIntent(const std::string &message, Intent expected, bool equal, const TopicRegistry &topics,
+                         const IntentClassifier &model) {
+    const IntentClassifier *classifiers[] = {nullptr, &model};
+    for (const IntentClassifier *classifier : classifiers) {
+        if (classifier && !classifier->loaded()) continue;
+        Intent got = parseIntentAndTopic(message, topics, classifier).first;
+        check((got == expected) == equal, "\"" + message + "\" parsed as " + intentName(got) +
+                                              (classifier ? " (with model)" : " (keywords only)"));
+    }
+}
+
+// A quiz question whose acceptable answers are keys
+static QuizBank::Question question(const std::vector<std::string> &keys, bool generated) {
+    QuizBank::Question q{"?", keys[0], {}, generated};
+    for (auto &k : keys) q.keys.push_back(QuizBank::words(k));
+    return q;
+}
+
+static void expectAnswer(const QuizBank::Question &q, const std::string &answer, bool accepted) {
+    check(QuizBank::accepts(q, answer) == accepted,
+          "\"" + answer + "\" " + (accepted ? "rejected" : "accepted") + " for \"" + q.a + "\"");
+}
+
+int main(int argc, char **argv) {
+    std::string data = "data";
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--data" && i + 1 < argc) {
+            data = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: selftest [--data dir]\n");
+            return 1;
+        }
+    }
+    TopicRegistry topics;
+    topics.scan(data + "/topics");
+    IntentClassifier model;
+    model.load(data + "/intent_model.txt");
+
+    // Exit and progress keywords only count as whole words
+    expectIntent("they depend on each other", Intent::Exit, false, topics, model);
+    expectIntent("what do you recommend", Intent::Exit, false, topics, model);
+    expectIntent("i attend every lecture", Intent::Exit, false, topics, model);
+    expectIntent("bye", Intent::Exit, true, topics, model);
+    expectIntent("ok goodbye for now", Intent::Exit, true, topics, model);
+    expectIntent("my progress so far", Intent::Progress, true, topics, model);
+    check(!containsWords("they depend on it", "end"), "\"end\" found inside \"depend\"");
+    check(containsWords("end session now", "end session"), "\"end session\" not found");
+
+    // Quiz answers: whole words of an accepted form, a plural counting as the word
+    QuizBank::Question complexity = question({"O(n)", "linear"}, true);
+    expectAnswer(complexity, "O(n)", true);
+    expectAnswer(complexity, "it is linear", true);
+    expectAnswer(complexity, "n", false);
+    expectAnswer(complexity, "line", false);
+    expectAnswer(complexity, "o(n^2)", false);
+    QuizBank::Question queue = question({"Queue"}, false);
+    expectAnswer(queue, "queue", true);
+    expectAnswer(queue, "queues", true);
+    expectAnswer(queue, "a queue", true);
+    expectAnswer(queue, "que", false);
+    expectAnswer(queue, "dequeue", false);
+    QuizBank::Question hashing = question({"hash table"}, false);
+    expectAnswer(hashing, "hash tables", true);
+
+    // A rescan renumbers topics and may drop some: history 0 > 1 > 2 > [1] with 2 gone keeps
+    // 1 current and collapses the visits of 1 around it
+    ConversationContext context;
+    for (int topic : {0, 1, 2, 1}) context.visit(topic);
+    context.remap({5, 3, -1});
+    check(context.size() == 2 && context.topicAt(0) == 5 && context.current() == 3, "history not remapped");
+    check(context.visited(3) && !context.visited(1) && context.visitOrder().size() == 2, "visited set not remapped");
+
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
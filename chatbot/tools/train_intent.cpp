@@ -0,0 +1,78 @@
+// Intent model trainer: reads labelled queries (data/intent_training.txt, "<intent><TAB><query>"
+// per line), trains the IntentClassifier and writes data/intent_model.txt for the chatbot.
+// Every fifth example is held out to report accuracy before the final model is fitted on all
+// of them. Training is seeded, so rerunning on the same file gives the same model.
+//
+// Build (from the chatbot folder):
+//   g++ -std=c++17 -O2 tools/train_intent.cpp IntentClassifier.cpp -o train_intent.exe
+// Run:
+//   .\train_intent.exe --data data --epochs 30 --seed 35
+#include "../IntentClassifier.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+    std::string dataPath = "data";
+    int epochs = 30;
+    float rate = 0.5f, l2 = 1e-5f;
+    uint64_t seed = 35;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        std::string v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--data") dataPath = v;
+        else if (a == "--epochs") epochs = std::atoi(v.c_str());
+        else if (a == "--rate") rate = (float)std::atof(v.c_str());
+        else if (a == "--l2") l2 = (float)std::atof(v.c_str());
+        else if (a == "--seed") seed = std::strtoull(v.c_str(), nullptr, 10);
+        else {
+            std::cout << "Usage: train_intent [--data <dir>] [--epochs N] [--rate R] [--l2 R] [--seed N]\n";
+            return 1;
+        }
+        ++i;
+    }
+
+    std::ifstream in(dataPath + "/intent_training.txt");
+    if (!in) {
+        std::cout << "Cannot open " << dataPath << "/intent_training.txt\n";
+        return 1;
+    }
+    std::vector<std::string> labels;
+    std::vector<IntentClassifier::Example> examples;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        std::string label = line.substr(0, tab);
+        auto it = std::find(labels.begin(), labels.end(), label);
+        if (it == labels.end()) it = labels.insert(labels.end(), label);
+        examples.push_back({line.substr(tab + 1), (int)(it - labels.begin())});
+    }
+    if (examples.empty()) {
+        std::cout << "No training examples found.\n";
+        return 1;
+    }
+
+    std::vector<IntentClassifier::Example> trainSet, heldOut;
+    for (size_t i = 0; i < examples.size(); ++i) (i % 5 == 4 ? heldOut : trainSet).push_back(examples[i]);
+
+    IntentClassifier model;
+    model.train(labels, trainSet, epochs, rate, l2, seed);
+    std::cout << examples.size() << " examples, " << labels.size() << " intents\n";
+    std::cout << "Held-out accuracy: " << model.accuracy(heldOut) * 100 << "%\n";
+
+    model.train(labels, examples, epochs, rate, l2, seed);
+    std::cout << "Training accuracy: " << model.accuracy(examples) * 100 << "%\n";
+    std::string outPath = dataPath + "/intent_model.txt";
+    if (!model.save(outPath)) {
+        std::cout << "Cannot write " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "Model written to " << outPath << "\n";
+    return 0;
+}